@@ -0,0 +1,1301 @@
+/*
+  ==============================================================================
+
+    A command-line app which builds and renders SOUL patches without any audio
+    hardware, and reports how long that takes.
+
+    Run it with --help to see the list of commands.
+
+  ==============================================================================
+*/
+
+#define DONT_SET_USING_JUCE_NAMESPACE 1
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include "../../../source/API/soul_patch/API/soul_patch.h"
+#include "../../../source/API/soul_patch/helper_classes/soul_patch_Utilities.h"
+#include "../../../source/API/soul_patch/helper_classes/soul_patch_Benchmark.h"
+#include "../../../source/API/soul_patch/helper_classes/soul_patch_AudioProcessor.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <new>
+#include <cstdlib>
+
+//==============================================================================
+/** Loads the patch library given by the --library option, or looks for it next to
+    this executable if the option isn't used.
+*/
+static std::unique_ptr<soul::patch::SOULPatchLibrary> loadLibrary (const juce::ArgumentList& args)
+{
+    auto file = args.containsOption ("--library")
+                    ? args.getFileForOption ("--library")
+                    : juce::File::getSpecialLocation (juce::File::currentExecutableFile)
+                          .getSiblingFile (soul::patch::SOULPatchLibrary::getLibraryFileName());
+
+    auto library = std::make_unique<soul::patch::SOULPatchLibrary> (file.getFullPathName().toRawUTF8());
+
+    if (! library->loadedSuccessfully())
+        juce::ConsoleApplication::fail ("Couldn't load the SOUL patch library from " + file.getFullPathName());
+
+    return library;
+}
+
+static juce::Array<double> getNumberListOption (const juce::ArgumentList& args, const char* option,
+                                                juce::Array<double> defaultValues)
+{
+    if (! args.containsOption (option))
+        return defaultValues;
+
+    juce::Array<double> values;
+
+    for (auto& item : juce::StringArray::fromTokens (args.getValueForOption (option), ",", {}))
+        if (item.trim().isNotEmpty())
+            values.add (item.getDoubleValue());
+
+    if (values.isEmpty())
+        juce::ConsoleApplication::fail ("Expected a comma-separated list of numbers after " + juce::String (option));
+
+    return values;
+}
+
+static double getNumberOption (const juce::ArgumentList& args, const char* option, double defaultValue)
+{
+    return args.containsOption (option) ? args.getValueForOption (option).getDoubleValue() : defaultValue;
+}
+
+//==============================================================================
+/** A temporary folder which holds patches that the app has generated. These are either
+    wrapped around a stand-alone .soul file, or written from scratch by one of the commands.
+    The folder is deleted when this object is.
+*/
+struct TemporaryPatchFolder
+{
+    TemporaryPatchFolder()
+    {
+        folder.createDirectory();
+    }
+
+    ~TemporaryPatchFolder()
+    {
+        folder.deleteRecursively();
+    }
+
+    /** Writes a patch with the given source code, and returns its manifest file. Any files
+        that the externals refer to should be written into getPatchFolder (name).
+    */
+    juce::File addPatch (const juce::String& name, const juce::String& soulCode, bool isInstrument,
+                         const juce::var& externals = {})
+    {
+        auto patchFolder = getPatchFolder (name);
+
+        auto sourceFile = patchFolder.getChildFile (name + ".soul");
+        auto manifestFile = patchFolder.getChildFile (name + soul::patch::getManifestSuffix());
+
+        auto properties = new juce::DynamicObject();
+        properties->setProperty ("ID",           "dev.soul.benchmark." + name.toLowerCase());
+        properties->setProperty ("version",      "1.0");
+        properties->setProperty ("name",         name);
+        properties->setProperty ("isInstrument", isInstrument);
+        properties->setProperty ("source",       sourceFile.getFileName());
+
+        if (! externals.isVoid())
+            properties->setProperty ("externals", externals);
+
+        auto manifest = new juce::DynamicObject();
+        manifest->setProperty (soul::patch::getManifestTopLevelPropertyName(), juce::var (properties));
+
+        if (! (sourceFile.replaceWithText (soulCode)
+                && manifestFile.replaceWithText (juce::JSON::toString (juce::var (manifest)))))
+            juce::ConsoleApplication::fail ("Couldn't write to " + patchFolder.getFullPathName());
+
+        return manifestFile;
+    }
+
+    /** Returns the folder for a patch with this name, creating it if needed. */
+    juce::File getPatchFolder (const juce::String& name) const
+    {
+        auto patchFolder = folder.getChildFile (name);
+        patchFolder.createDirectory();
+        return patchFolder;
+    }
+
+    /** Wraps a stand-alone .soul file in a patch. */
+    juce::File addPatch (const juce::File& soulFile)
+    {
+        auto code = soulFile.loadFileAsString();
+        return addPatch (soulFile.getFileNameWithoutExtension(), code, code.contains ("midi::Message"));
+    }
+
+    const juce::File folder { juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                .getNonexistentChildFile ("soul_benchmark", {}, false) };
+};
+
+/** Finds the patches that the command-line arguments refer to. Each argument can be a
+    .soulpatch file, a folder to search for them, a .soul file, or a JSON list of .soul
+    files such as examples/standalone/examples.json.
+*/
+static juce::Array<juce::File> findPatches (const juce::ArgumentList& args, TemporaryPatchFolder& generatedPatches)
+{
+    juce::Array<juce::File> patches;
+
+    for (auto& arg : args.arguments)
+    {
+        if (arg.isOption())
+            continue;
+
+        auto file = arg.resolveAsFile();
+
+        if (file.isDirectory())
+        {
+            auto found = file.findChildFiles (juce::File::findFiles, true, soul::patch::getManifestWildcard());
+            found.sort();
+            patches.addArray (found);
+        }
+        else if (file.hasFileExtension (soul::patch::getManifestSuffix()))
+        {
+            patches.add (file);
+        }
+        else if (file.hasFileExtension (".soul"))
+        {
+            patches.add (generatedPatches.addPatch (file));
+        }
+        else if (file.hasFileExtension (".json"))
+        {
+            auto list = juce::JSON::parse (file);
+
+            if (! list.isArray())
+                juce::ConsoleApplication::fail ("Expected " + file.getFullPathName() + " to contain a list of files");
+
+            for (auto& item : *list.getArray())
+                patches.add (generatedPatches.addPatch (file.getSiblingFile (item.toString())));
+        }
+        else
+        {
+            juce::ConsoleApplication::fail ("Don't know what to do with " + file.getFullPathName());
+        }
+    }
+
+    if (patches.isEmpty())
+        juce::ConsoleApplication::fail ("No patches were given");
+
+    return patches;
+}
+
+//==============================================================================
+static void printResults (const std::vector<soul::patch::PatchBenchmark::Result>& results)
+{
+    for (auto& r : results)
+    {
+        auto line = juce::String (r.patchName).paddedRight (' ', 24)
+                     + juce::String (r.sampleRate, 0).paddedLeft (' ', 7) + "Hz"
+                     + juce::String (r.blockSize).paddedLeft (' ', 6) + "  ";
+
+        if (r.succeeded())
+            line << "build " << juce::String (r.buildSeconds * 1000.0, 1) << "ms, "
+                 << "x" << juce::String (r.realTimeFactor, 1) << " real-time, "
+                 << "p99 block " << juce::String (r.p99BlockSeconds * 1.0e6, 1) << "us, "
+                 << "jitter " << juce::String (r.blockJitter * 100.0, 1) << "%";
+        else
+            line << "FAILED: " << juce::String (r.error);
+
+        std::cout << line << std::endl;
+    }
+}
+
+static void runBenchmark (const juce::ArgumentList& args)
+{
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+    auto patches = findPatches (args, generatedPatches);
+
+    soul::patch::PatchBenchmark::Settings settings;
+    settings.secondsToRender = getNumberOption (args, "--seconds", settings.secondsToRender);
+    settings.sampleRates.clear();
+    settings.blockSizes.clear();
+
+    for (auto rate : getNumberListOption (args, "--rates", { 44100.0, 48000.0, 96000.0 }))
+        settings.sampleRates.push_back (rate);
+
+    for (auto size : getNumberListOption (args, "--blocks", { 32.0, 128.0, 512.0, 2048.0 }))
+        settings.blockSizes.push_back ((uint32_t) size);
+
+    auto results = soul::patch::PatchBenchmark::run (*library, patches, settings);
+    printResults (results);
+
+    auto json = soul::patch::PatchBenchmark::toJSON (results);
+
+    if (args.containsOption ("--output"))
+    {
+        auto outputFile = args.getFileForOption ("--output");
+
+        if (! outputFile.replaceWithText (juce::JSON::toString (json)))
+            juce::ConsoleApplication::fail ("Couldn't write to " + outputFile.getFullPathName());
+    }
+
+    if (args.containsOption ("--baseline"))
+    {
+        auto baseline = juce::JSON::parse (args.getExistingFileForOption ("--baseline"));
+        auto regressions = soul::patch::PatchBenchmark::findRegressions (json, baseline, getNumberOption (args, "--tolerance", 0.1));
+
+        if (! regressions.isEmpty())
+            juce::ConsoleApplication::fail ("Performance regressions found:\n  " + regressions.joinIntoString ("\n  "));
+
+        std::cout << "No regressions against the baseline" << std::endl;
+    }
+}
+
+//==============================================================================
+/** A patch instance and a player which has been built from it. */
+struct LoadedPlayer
+{
+    soul::patch::PatchInstance::Ptr patch;
+    soul::patch::PatchPlayer::Ptr player;
+};
+
+static LoadedPlayer buildPlayer (const soul::patch::SOULPatchLibrary& library, const juce::File& manifestFile,
+                                 double sampleRate, uint32_t blockSize)
+{
+    LoadedPlayer result;
+    result.patch = library.createPatchFromFileBundle (manifestFile.getFullPathName().toRawUTF8());
+
+    if (result.patch == nullptr)
+        juce::ConsoleApplication::fail ("Failed to load " + manifestFile.getFullPathName());
+
+    soul::patch::PatchPlayerConfiguration config;
+    config.sampleRate = sampleRate;
+    config.maxFramesPerBlock = blockSize;
+
+    juce::String error;
+    result.player = soul::patch::compilePlayableNewPlayer (*result.patch, config, error);
+
+    if (result.player == nullptr)
+        juce::ConsoleApplication::fail (manifestFile.getFileNameWithoutExtension() + ": " + error);
+
+    return result;
+}
+
+/** Renders a number of blocks of silence, and returns the average time spent in each
+    render() call. The callback is invoked before each block, and the time it takes isn't
+    included.
+*/
+static double measureRenderTime (soul::patch::PatchPlayer& player, uint32_t blockSize, int numBlocks,
+                                 std::function<void (int block)> beforeEachBlock)
+{
+    auto numInputChannels  = soul::patch::getTotalNumChannels (player.getInputBuses());
+    auto numOutputChannels = soul::patch::getTotalNumChannels (player.getOutputBuses());
+
+    juce::AudioBuffer<float> inputs ((int) numInputChannels, (int) blockSize),
+                             outputs ((int) numOutputChannels, (int) blockSize);
+    inputs.clear();
+    std::vector<soul::patch::MIDIMessage> midi;
+
+    auto rc = soul::patch::createRenderContext (inputs.getArrayOfReadPointers(), numInputChannels,
+                                                outputs.getArrayOfWritePointers(), numOutputChannels,
+                                                midi, blockSize);
+    std::chrono::duration<double> total {};
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        if (beforeEachBlock != nullptr)
+            beforeEachBlock (i);
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (player.render (rc) != soul::patch::PatchPlayer::RenderResult::ok)
+            juce::ConsoleApplication::fail ("Render failed");
+
+        total += std::chrono::steady_clock::now() - start;
+    }
+
+    return total.count() / std::max (1, numBlocks);
+}
+
+//==============================================================================
+/** Creates a processor with the given number of parameters, each of which has an event
+    handler that does a trivial amount of work.
+*/
+static juce::String createParameterTestCode (int numParameters)
+{
+    juce::String declarations, handlers;
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        declarations << "        float param" << i << " [[ min: 0, max: 1, init: 0 ]];\n";
+        handlers << "    event param" << i << " (float v)  { total += v; }\n";
+    }
+
+    return "processor ParameterCount  [[ main ]]\n"
+           "{\n"
+           "    output stream float audioOut;\n"
+           "\n"
+           "    input event\n"
+           "    {\n"
+           + declarations +
+           "    }\n"
+           "\n"
+           + handlers +
+           "\n"
+           "    float total;\n"
+           "\n"
+           "    void run()\n"
+           "    {\n"
+           "        loop\n"
+           "        {\n"
+           "            audioOut << total * 0.001f;\n"
+           "            advance();\n"
+           "        }\n"
+           "    }\n"
+           "}\n";
+}
+
+/** Measures how the cost of a render call grows with the number of parameters a patch has,
+    when none of them change, when one changes before each block, and when they all do.
+*/
+static void runParameterCountBenchmark (const juce::ArgumentList& args)
+{
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+
+    auto sampleRate = getNumberOption (args, "--rate", 48000.0);
+    auto blockSize = (uint32_t) getNumberOption (args, "--block", 256);
+    auto numBlocks = (int) (getNumberOption (args, "--seconds", 10.0) * sampleRate / blockSize);
+
+    std::cout << "Parameters   idle (us/block)   1 change (us/block)   all changed (us/block)" << std::endl;
+
+    for (auto count : getNumberListOption (args, "--counts", { 1.0, 10.0, 100.0, 500.0, 1000.0 }))
+    {
+        auto numParameters = juce::jmax (1, (int) count);
+        auto manifest = generatedPatches.addPatch ("ParameterCount" + juce::String (numParameters),
+                                                   createParameterTestCode (numParameters), false);
+        auto loaded = buildPlayer (*library, manifest, sampleRate, blockSize);
+        auto parameters = loaded.player->getParameters();
+
+        auto idle = measureRenderTime (*loaded.player, blockSize, numBlocks, nullptr);
+
+        auto oneChange = measureRenderTime (*loaded.player, blockSize, numBlocks, [&] (int block)
+        {
+            parameters[(size_t) block % parameters.size()]->setValue ((float) ((block / (int) parameters.size()) & 1));
+        });
+
+        auto allChanged = measureRenderTime (*loaded.player, blockSize, numBlocks, [&] (int block)
+        {
+            for (auto& p : parameters)
+                p->setValue ((float) (block & 1));
+        });
+
+        std::cout << juce::String (numParameters).paddedLeft (' ', 10)
+                  << juce::String (idle * 1.0e6, 2).paddedLeft (' ', 18)
+                  << juce::String (oneChange * 1.0e6, 2).paddedLeft (' ', 22)
+                  << juce::String (allChanged * 1.0e6, 2).paddedLeft (' ', 25) << std::endl;
+    }
+}
+
+//==============================================================================
+/** Creates a number of processors for each patch at once, as a host does when it opens a
+    session, and measures how long it takes before each of them has rendered a block of audio.
+    The clock starts before the patches are loaded, and the processors' builds are queued
+    on the shared PatchCompileService in the same way as they are in a host.
+*/
+static void runTimeToFirstAudioBenchmark (const juce::ArgumentList& args)
+{
+    // The processors hand their new players over to the host on the message thread
+    juce::ScopedJuceInitialiser_GUI messageManager;
+
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+    auto patches = findPatches (args, generatedPatches);
+
+    auto sampleRate = getNumberOption (args, "--rate", 48000.0);
+    auto blockSize = (int) getNumberOption (args, "--block", 256);
+    auto timeoutMs = 1000.0 * getNumberOption (args, "--timeout", 120.0);
+
+    std::cout << "Patch                   Instances   first (ms)   median (ms)   last (ms)" << std::endl;
+
+    for (auto& manifest : patches)
+    {
+        for (auto count : getNumberListOption (args, "--instances", { 1.0, 8.0, 32.0, 128.0 }))
+        {
+            auto numInstances = (size_t) juce::jmax (1, (int) count);
+            std::vector<double> readyTimes;
+            size_t numFailed = 0;
+            std::vector<std::unique_ptr<soul::patch::SOULPatchAudioProcessor>> processors;
+
+            auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+            for (size_t i = 0; i < numInstances; ++i)
+            {
+                auto patch = library->createPatchFromFileBundle (manifest.getFullPathName().toRawUTF8());
+
+                if (patch == nullptr)
+                    juce::ConsoleApplication::fail ("Failed to load " + manifest.getFullPathName());
+
+                processors.push_back (std::make_unique<soul::patch::SOULPatchAudioProcessor> (patch));
+                auto& processor = *processors.back();
+
+                // This is called when the processor's first build has finished
+                processor.askHostToReinitialise = [&, startTime]
+                {
+                    processor.reinitialise();
+                    processor.prepareToPlay (sampleRate, blockSize);
+
+                    if (! processor.isPlayable())
+                    {
+                        ++numFailed;
+                        return;
+                    }
+
+                    juce::AudioBuffer<float> audio (juce::jmax (1, processor.getTotalNumInputChannels(),
+                                                                processor.getTotalNumOutputChannels()), blockSize);
+                    juce::MidiBuffer midi;
+                    audio.clear();
+                    processor.processBlock (audio, midi);
+
+                    readyTimes.push_back (juce::Time::getMillisecondCounterHiRes() - startTime);
+                };
+
+                processor.prepareToPlay (sampleRate, blockSize);
+            }
+
+            while (readyTimes.size() + numFailed < numInstances
+                     && juce::Time::getMillisecondCounterHiRes() < startTime + timeoutMs)
+                juce::MessageManager::getInstance()->runDispatchLoopUntil (5);
+
+            auto line = manifest.getFileNameWithoutExtension().paddedRight (' ', 24)
+                          + juce::String ((int) numInstances).paddedLeft (' ', 9);
+
+            if (readyTimes.size() < numInstances)
+            {
+                line << "   " << juce::String ((int) (numInstances - readyTimes.size())) << " instances "
+                     << (numFailed > 0 ? "failed to build" : "timed out");
+            }
+            else
+            {
+                std::sort (readyTimes.begin(), readyTimes.end());
+
+                line << juce::String (readyTimes.front(), 1).paddedLeft (' ', 13)
+                     << juce::String (readyTimes[readyTimes.size() / 2], 1).paddedLeft (' ', 14)
+                     << juce::String (readyTimes.back(), 1).paddedLeft (' ', 12);
+            }
+
+            std::cout << line << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+static juce::String createFastMathTestCode (const juce::String& function, int numLanes, bool useFastMath)
+{
+    auto type = numLanes == 1 ? juce::String ("float") : "float<" + juce::String (numLanes) + ">";
+
+    return "processor FastMathTest  [[ main" + juce::String (useFastMath ? ", fastMath" : "") + " ]]\n"
+           "{\n"
+           "    input stream " + type + " in;\n"
+           "    output stream " + type + " out;\n"
+           "\n"
+           "    void run()\n"
+           "    {\n"
+           "        loop\n"
+           "        {\n"
+           "            out << " + function + " (in);\n"
+           "            advance();\n"
+           "        }\n"
+           "    }\n"
+           "}\n";
+}
+
+/** The largest error and the average cost per value of one build of a function. */
+struct FastMathMeasurement
+{
+    double maxError = 0, nanosecondsPerValue = 0;
+};
+
+/** Sends a sweep of evenly-spaced values across a range through a player which applies a
+    function to its inputs, and compares the results with the float64 version from the
+    standard library. The time spent in render() is also measured.
+*/
+static FastMathMeasurement measureFunction (soul::patch::PatchPlayer& player, double low, double high, int numValues,
+                                           bool useRelativeError, std::function<double (double)> reference)
+{
+    static constexpr uint32_t blockSize = 512;
+    auto numChannels = soul::patch::getTotalNumChannels (player.getInputBuses());
+
+    juce::AudioBuffer<float> inputs ((int) numChannels, (int) blockSize),
+                             outputs ((int) numChannels, (int) blockSize);
+    std::vector<soul::patch::MIDIMessage> midi;
+    auto numFrames = (numValues + (int) numChannels - 1) / (int) numChannels;
+
+    FastMathMeasurement result;
+    std::chrono::duration<double> renderTime {};
+
+    for (int blockStart = 0; blockStart < numFrames; blockStart += (int) blockSize)
+    {
+        auto numFramesInBlock = (uint32_t) juce::jmin ((int) blockSize, numFrames - blockStart);
+
+        auto getInputValue = [&] (uint32_t chan, uint32_t frame)
+        {
+            auto index = (blockStart + (int) frame) * (int) numChannels + (int) chan;
+            return (float) (low + (high - low) * index / (numFrames * (int) numChannels - 1));
+        };
+
+        for (uint32_t chan = 0; chan < numChannels; ++chan)
+            for (uint32_t frame = 0; frame < numFramesInBlock; ++frame)
+                inputs.setSample ((int) chan, (int) frame, getInputValue (chan, frame));
+
+        auto rc = soul::patch::createRenderContext (inputs.getArrayOfReadPointers(), numChannels,
+                                                    outputs.getArrayOfWritePointers(), numChannels,
+                                                    midi, numFramesInBlock);
+        auto start = std::chrono::steady_clock::now();
+
+        if (player.render (rc) != soul::patch::PatchPlayer::RenderResult::ok)
+            juce::ConsoleApplication::fail ("Render failed");
+
+        renderTime += std::chrono::steady_clock::now() - start;
+
+        for (uint32_t chan = 0; chan < numChannels; ++chan)
+        {
+            for (uint32_t frame = 0; frame < numFramesInBlock; ++frame)
+            {
+                auto expected = reference ((double) getInputValue (chan, frame));
+                auto error = std::abs ((double) outputs.getSample ((int) chan, (int) frame) - expected);
+
+                if (useRelativeError)
+                    error /= juce::jmax (std::abs (expected), 1.0e-30);
+
+                result.maxError = juce::jmax (result.maxError, error);
+            }
+        }
+    }
+
+    result.nanosecondsPerValue = renderTime.count() * 1.0e9 / (numFrames * (int) numChannels);
+    return result;
+}
+
+/** Compares the accuracy and speed of the fast-math approximations with the standard
+    versions of the same functions, for scalars and for vectors.
+*/
+static void runFastMathBenchmark (const juce::ArgumentList& args)
+{
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+    auto numValues = (int) getNumberOption (args, "--values", 1 << 20);
+
+    struct FunctionTest
+    {
+        const char* name;
+        double low, high;
+        bool useRelativeError, supportsVectors;
+        std::function<double (double)> reference;
+    };
+
+    // The standard library's tanh() doesn't accept vectors, so there's nothing to compare the fast one with
+    const FunctionTest tests[] =
+    {
+        { "sin",  -1000.0, 1000.0, false, true,  [] (double x) { return std::sin (x); } },
+        { "cos",  -1000.0, 1000.0, false, true,  [] (double x) { return std::cos (x); } },
+        { "tan",  -1.5,    1.5,    true,  true,  [] (double x) { return std::tan (x); } },
+        { "exp",  -87.0,   88.0,   true,  true,  [] (double x) { return std::exp (x); } },
+        { "tanh", -10.0,   10.0,   false, false, [] (double x) { return std::tanh (x); } }
+    };
+
+    std::cout << "Function   Lanes  Range            Error       standard        fast  standard (ns)   fast (ns)" << std::endl;
+
+    for (auto& test : tests)
+    {
+        for (int numLanes : { 1, 4 })
+        {
+            if (numLanes > 1 && ! test.supportsVectors)
+                continue;
+
+            FastMathMeasurement measurements[2];
+
+            for (int useFastMath = 0; useFastMath < 2; ++useFastMath)
+            {
+                auto name = juce::String ("FastMath_") + test.name + "_" + juce::String (numLanes) + (useFastMath ? "_fast" : "_standard");
+                auto manifest = generatedPatches.addPatch (name, createFastMathTestCode (test.name, numLanes, useFastMath != 0), false);
+                auto loaded = buildPlayer (*library, manifest, 48000.0, 512);
+
+                measurements[useFastMath] = measureFunction (*loaded.player, test.low, test.high, numValues,
+                                                             test.useRelativeError, test.reference);
+            }
+
+            std::cout << juce::String (test.name).paddedRight (' ', 9)
+                      << juce::String (numLanes).paddedLeft (' ', 7)
+                      << ("  [" + juce::String (test.low) + ", " + juce::String (test.high) + "]").paddedRight (' ', 19)
+                      << (test.useRelativeError ? "relative" : "absolute")
+                      << juce::String (measurements[0].maxError, 3, true).paddedLeft (' ', 12)
+                      << juce::String (measurements[1].maxError, 3, true).paddedLeft (' ', 12)
+                      << juce::String (measurements[0].nanosecondsPerValue, 2).paddedLeft (' ', 15)
+                      << juce::String (measurements[1].nanosecondsPerValue, 2).paddedLeft (' ', 12) << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+/** Creates a block of deterministic noise to be resampled. */
+static juce::AudioBuffer<float> createNoise (int numChannels, int numFrames)
+{
+    juce::AudioBuffer<float> buffer (numChannels, numFrames);
+    juce::Random random (1234);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+        for (int i = 0; i < numFrames; ++i)
+            buffer.setSample (chan, i, random.nextFloat() * 2.0f - 1.0f);
+
+    return buffer;
+}
+
+static juce::String getThroughputDescription (double seconds, int numChannels, int numSourceFrames)
+{
+    return juce::String (seconds * 1000.0, 1).paddedLeft (' ', 10) + "ms"
+            + juce::String (numChannels * (double) numSourceFrames / (seconds * 1.0e6), 2).paddedLeft (' ', 12) + " Msamples/s";
+}
+
+static juce::String createResampleTestCode (int numChannels, double resampleRate)
+{
+    auto type = numChannels == 1 ? juce::String ("float") : "float<" + juce::String (numChannels) + ">";
+
+    return "processor ResampleLoad  [[ main ]]\n"
+           "{\n"
+           "    output stream " + type + " audioOut;\n"
+           "\n"
+           "    external " + type + "[] sampleData" + (resampleRate > 0 ? " [[ resample: " + juce::String (resampleRate) + " ]]" : juce::String()) + ";\n"
+           "\n"
+           "    void run()\n"
+           "    {\n"
+           "        wrap<1024> i;\n"
+           "\n"
+           "        loop\n"
+           "        {\n"
+           "            audioOut << sampleData.at (i++);\n"
+           "            advance();\n"
+           "        }\n"
+           "    }\n"
+           "}\n";
+}
+
+/** Measures how quickly external audio data is resampled when a patch is loaded.
+
+    First the resampling functions are timed on their own: the original resampleToFit(),
+    and fastResampleToFit() both on the calling thread and spread across a ThreadPool,
+    which is how the patch loader uses it. Then a WAV file is written into two generated
+    patches, one of which asks for it to be resampled, and the time taken to load and build
+    each of them through the patch library is compared.
+*/
+static void runResampleBenchmark (const juce::ArgumentList& args)
+{
+    auto numChannels = juce::jlimit (1, 8, (int) getNumberOption (args, "--channels", 2));
+    auto sourceRate  = getNumberOption (args, "--from", 44100.0);
+    auto destRate    = getNumberOption (args, "--to", 48000.0);
+    auto numFrames   = (int) (getNumberOption (args, "--seconds", 10.0) * sourceRate);
+    auto numDestFrames = (int) (numFrames * destRate / sourceRate + 0.5);
+
+    auto source = createNoise (numChannels, numFrames);
+    juce::AudioBuffer<float> dest (numChannels, numDestFrames);
+
+    // resampleToFit() needs the source and destination to be the same type
+    soul::DiscreteChannelSet<float> sourceChannels { source.getArrayOfWritePointers(), (uint32_t) numChannels, 0, (uint32_t) numFrames };
+    soul::DiscreteChannelSet<const float> constSourceChannels { source.getArrayOfReadPointers(), (uint32_t) numChannels, 0, (uint32_t) numFrames };
+    soul::DiscreteChannelSet<float> destChannels { dest.getArrayOfWritePointers(), (uint32_t) numChannels, 0, (uint32_t) numDestFrames };
+
+    auto timeFunction = [] (std::function<void()> f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::cout << "Resampling " << numChannels << " channels of " << numFrames << " frames from "
+              << sourceRate << "Hz to " << destRate << "Hz" << std::endl;
+
+    soul::ThreadPool pool;
+
+    std::cout << "resampleToFit                  "
+              << getThroughputDescription (timeFunction ([&] { soul::resampleToFit (destChannels, sourceChannels); }), numChannels, numFrames) << std::endl;
+
+    std::cout << "fastResampleToFit              "
+              << getThroughputDescription (timeFunction ([&] { soul::fastResampleToFit (destChannels, constSourceChannels, nullptr); }), numChannels, numFrames) << std::endl;
+
+    std::cout << ("fastResampleToFit, " + juce::String (pool.getNumThreads()) + " threads").paddedRight (' ', 31)
+              << getThroughputDescription (timeFunction ([&] { soul::fastResampleToFit (destChannels, constSourceChannels, &pool); }), numChannels, numFrames) << std::endl;
+
+    if (args.containsOption ("--skip-patch"))
+        return;
+
+    // The same file is loaded by two patches, and only one of them asks for it to be resampled,
+    // so the difference between their load times is the cost of resampling in the loader
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+    double loadSeconds[2] = {};
+
+    for (int i = 0; i < 2; ++i)
+    {
+        auto shouldResample = i == 1;
+        auto name = juce::String (shouldResample ? "ResampleLoad" : "PlainLoad");
+        auto wavFile = generatedPatches.getPatchFolder (name).getChildFile ("sample.wav");
+
+        {
+            std::unique_ptr<juce::OutputStream> stream (wavFile.createOutputStream());
+            std::unique_ptr<juce::AudioFormatWriter> writer (juce::WavAudioFormat().createWriterFor (stream.get(), sourceRate, (unsigned int) numChannels, 32, {}, 0));
+
+            if (writer == nullptr)
+                juce::ConsoleApplication::fail ("Couldn't write to " + wavFile.getFullPathName());
+
+            stream.release();
+            writer->writeFromAudioSampleBuffer (source, 0, numFrames);
+        }
+
+        auto externals = new juce::DynamicObject();
+        externals->setProperty ("ResampleLoad::sampleData", wavFile.getFileName());
+
+        auto manifest = generatedPatches.addPatch (name, createResampleTestCode (numChannels, shouldResample ? destRate : 0),
+                                                   false, juce::var (externals));
+
+        loadSeconds[i] = timeFunction ([&] { buildPlayer (*library, manifest, destRate, 512); });
+    }
+
+    std::cout << "Patch load without resampling  " << juce::String (loadSeconds[0] * 1000.0, 1).paddedLeft (' ', 10) << "ms" << std::endl
+              << "Patch load with resampling     " << juce::String (loadSeconds[1] * 1000.0, 1).paddedLeft (' ', 10) << "ms" << std::endl;
+
+    if (loadSeconds[1] > loadSeconds[0])
+        std::cout << "Resampling in the loader       " << getThroughputDescription (loadSeconds[1] - loadSeconds[0], numChannels, numFrames) << std::endl;
+}
+
+//==============================================================================
+/** Counts the heap operations made by any thread while it has a ScopedAllocationCounter.
+
+    Only the allocations that go through this executable's operator new are seen. On Linux
+    the patch loader library normally uses the same one, so its allocations are included,
+    but on macOS and Windows the library gets its own copy, and anything that the player
+    allocates inside it won't be counted.
+*/
+namespace AllocationCounter
+{
+    static thread_local bool isCounting = false;
+    static std::atomic<int64_t> numAllocations { 0 }, numDeallocations { 0 };
+
+    struct ScopedAllocationCounter
+    {
+        ScopedAllocationCounter()   { isCounting = true; }
+        ~ScopedAllocationCounter()  { isCounting = false; }
+    };
+
+    static void* allocate (size_t size) noexcept
+    {
+        if (isCounting)
+            ++numAllocations;
+
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    static void deallocate (void* p) noexcept
+    {
+        if (isCounting && p != nullptr)
+            ++numDeallocations;
+
+        std::free (p);
+    }
+}
+
+void* operator new (size_t size)
+{
+    if (auto p = AllocationCounter::allocate (size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)                                  { return operator new (size); }
+void* operator new (size_t size, const std::nothrow_t&) noexcept    { return AllocationCounter::allocate (size); }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept  { return AllocationCounter::allocate (size); }
+void operator delete (void* p) noexcept                             { AllocationCounter::deallocate (p); }
+void operator delete[] (void* p) noexcept                           { AllocationCounter::deallocate (p); }
+void operator delete (void* p, size_t) noexcept                     { AllocationCounter::deallocate (p); }
+void operator delete[] (void* p, size_t) noexcept                   { AllocationCounter::deallocate (p); }
+void operator delete (void* p, const std::nothrow_t&) noexcept      { AllocationCounter::deallocate (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept    { AllocationCounter::deallocate (p); }
+
+static juce::String createAllocationTestCode (float outputLevel)
+{
+    return "processor AllocationTest  [[ main ]]\n"
+           "{\n"
+           "    input event midi::Message midiIn;\n"
+           "    input event float gain [[ min: 0, max: 1, init: 0.5 ]];\n"
+           "    input stream float audioIn;\n"
+           "    output stream float audioOut;\n"
+           "\n"
+           "    event midiIn (midi::Message m)  { ++numMessages; }\n"
+           "    event gain (float g)            { currentGain = g; }\n"
+           "\n"
+           "    float currentGain = 0.5f;\n"
+           "    int numMessages;\n"
+           "\n"
+           "    void run()\n"
+           "    {\n"
+           "        loop\n"
+           "        {\n"
+           "            audioOut << " + juce::String (outputLevel) + "f + audioIn * currentGain;\n"
+           "            advance();\n"
+           "        }\n"
+           "    }\n"
+           "}\n";
+}
+
+/** Checks that SOULPatchAudioProcessor::processBlock doesn't allocate or free any memory.
+
+    A generated patch is played in a SOULPatchAudioProcessor on a separate audio thread,
+    which changes a parameter and sends some MIDI to it before every block. While that's
+    running, the patch's source file is rewritten a few times so that the processor rebuilds
+    it and hot-swaps the new player in. Each version outputs a different constant level, so
+    the audio thread's output shows when a swap has finished. The command fails if the
+    audio thread allocated or freed anything inside processBlock, or if the processor asked
+    the host to reinitialise it instead of swapping the player itself.
+*/
+static void runAllocationTest (const juce::ArgumentList& args)
+{
+    // The processor hands its first player over to the host, and swaps in later ones, on the message thread
+    juce::ScopedJuceInitialiser_GUI messageManager;
+
+    auto library = loadLibrary (args);
+    TemporaryPatchFolder generatedPatches;
+
+    auto sampleRate = getNumberOption (args, "--rate", 48000.0);
+    auto blockSize = (int) getNumberOption (args, "--block", 256);
+    auto numSwaps = juce::jmax (1, (int) getNumberOption (args, "--swaps", 3));
+    auto timeoutMs = 1000.0 * getNumberOption (args, "--timeout", 60.0);
+
+    float outputLevel = 0.25f;
+    auto manifest = generatedPatches.addPatch ("AllocationTest", createAllocationTestCode (outputLevel), true);
+    auto sourceFile = manifest.getSiblingFile ("AllocationTest.soul");
+
+    auto patch = library->createPatchFromFileBundle (manifest.getFullPathName().toRawUTF8());
+
+    if (patch == nullptr)
+        juce::ConsoleApplication::fail ("Failed to load " + manifest.getFullPathName());
+
+    soul::patch::SOULPatchAudioProcessor processor (patch);
+    processor.setHotSwapCrossfadeLength (0.01);
+
+    bool isReady = false;
+    int numReinitialiseRequests = 0;
+
+    // The first build always needs the host to reinitialise the processor, but none of the later ones should
+    processor.askHostToReinitialise = [&]
+    {
+        if (isReady)
+        {
+            ++numReinitialiseRequests;
+            return;
+        }
+
+        processor.reinitialise();
+        processor.prepareToPlay (sampleRate, blockSize);
+        isReady = true;
+    };
+
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    auto waitUntil = [&] (std::function<bool()> condition)
+    {
+        auto endTime = juce::Time::getMillisecondCounterHiRes() + timeoutMs;
+
+        while (! condition())
+        {
+            if (juce::Time::getMillisecondCounterHiRes() > endTime)
+                return false;
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (5);
+        }
+
+        return true;
+    };
+
+    if (! (waitUntil ([&] { return isReady; }) && processor.isPlayable()))
+        juce::ConsoleApplication::fail ("The test patch didn't build: " + processor.getCompileError());
+
+    auto* gainParameter = processor.getParameters()[0];
+
+    if (gainParameter == nullptr)
+        juce::ConsoleApplication::fail ("The test patch has no parameters");
+
+    std::atomic<bool> shouldStop { false };
+    std::atomic<float> lastOutputLevel { 0 };
+    std::atomic<int> numBlocks { 0 };
+
+    std::thread audioThread ([&]
+    {
+        juce::AudioBuffer<float> audio (juce::jmax (1, processor.getTotalNumInputChannels(),
+                                                    processor.getTotalNumOutputChannels()), blockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize (1024);
+        auto blockDuration = std::chrono::duration<double> (blockSize / sampleRate);
+
+        for (int block = 0; ! shouldStop; ++block)
+        {
+            // Filling in the buffers is the host's job, so it's done before counting starts
+            audio.clear();
+            midi.addEvent (juce::MidiMessage::noteOn (1, 60 + block % 12, 0.8f), 0);
+            midi.addEvent (juce::MidiMessage::noteOff (1, 60 + block % 12), blockSize / 2);
+
+            {
+                AllocationCounter::ScopedAllocationCounter counter;
+                gainParameter->setValue ((block & 1) != 0 ? 0.25f : 0.75f);
+                processor.processBlock (audio, midi);
+            }
+
+            lastOutputLevel = audio.getSample (0, blockSize - 1);
+            ++numBlocks;
+            std::this_thread::sleep_for (blockDuration);
+        }
+    });
+
+    bool allSwapsFinished = true;
+
+    for (int i = 0; i < numSwaps && allSwapsFinished; ++i)
+    {
+        // Rewriting the source with a new modification time makes the processor's next poll rebuild it
+        outputLevel = outputLevel < 0.5f ? 0.75f : 0.25f;
+
+        if (! sourceFile.replaceWithText (createAllocationTestCode (outputLevel)))
+            juce::ConsoleApplication::fail ("Couldn't write to " + sourceFile.getFullPathName());
+
+        sourceFile.setLastModificationTime (juce::Time::getCurrentTime() + juce::RelativeTime::minutes (i + 1));
+
+        allSwapsFinished = waitUntil ([&] { return std::abs (lastOutputLevel - outputLevel) < 1.0e-4f
+                                                     || numReinitialiseRequests != 0; })
+                             && numReinitialiseRequests == 0;
+
+        auto blocksAfterSwap = numBlocks + 10;
+        waitUntil ([&] { return numBlocks >= blocksAfterSwap; });
+
+        std::cout << "Swap " << (i + 1) << ": " << (allSwapsFinished ? "done" : "failed") << std::endl;
+    }
+
+    shouldStop = true;
+    audioThread.join();
+    processor.releaseResources();
+
+    std::cout << numBlocks << " blocks rendered, with " << AllocationCounter::numAllocations << " allocations and "
+              << AllocationCounter::numDeallocations << " deallocations inside processBlock" << std::endl;
+
+    if (numReinitialiseRequests != 0)
+        juce::ConsoleApplication::fail ("The processor asked the host to reinitialise it instead of swapping its player");
+
+    if (! allSwapsFinished)
+        juce::ConsoleApplication::fail ("The rebuilt player wasn't swapped in within the timeout");
+
+    if (AllocationCounter::numAllocations != 0 || AllocationCounter::numDeallocations != 0)
+        juce::ConsoleApplication::fail ("processBlock allocated or freed memory");
+}
+
+//==============================================================================
+/** Generates a source file of roughly the given size, made of many functions which use a
+    mixture of identifiers, keywords, literals, operators and comments. It only needs to be
+    tokenised, so it doesn't have to compile.
+*/
+static std::string createTokeniserTestCode (size_t targetSize)
+{
+    std::string code = "namespace TokeniserTest\n{\n";
+
+    for (int i = 0; code.size() < targetSize; ++i)
+    {
+        auto n = std::to_string (i);
+
+        code += "    /** Function number " + n + ", which has a block comment. */\n"
+                "    float<4> function" + n + " (float<4> input, int64 count, const bool& flag)\n"
+                "    {\n"
+                "        let scaled = input * 0.5f + float<4> (1.0e-3f, 2.5f, -" + n + ".0f, 0x1F);  // a line comment\n"
+                "        var total = count << 2;\n"
+                "\n"
+                "        for (wrap<16> j = 0; j < 15; ++j)\n"
+                "            total += (j * " + n + "L) % 7 != 0 ? int64 (j) : -1L;\n"
+                "\n"
+                "        if (flag && total >= 0 || count == " + n + ")\n"
+                "            return scaled / float (total + 1);\n"
+                "\n"
+                "        console << \"value: \" << total;\n"
+                "        return function" + std::to_string (i / 2) + " (scaled, total - 1, ! flag);\n"
+                "    }\n"
+                "\n";
+    }
+
+    return code + "}\n";
+}
+
+/** Measures how quickly the compiler's tokeniser gets through some source code.
+
+    The built-in library, a large generated source file and any .soul files given on the
+    command line are each tokenised several times, and the fastest run for each is used
+    to print its throughput in MB/s and millions of tokens per second.
+*/
+static void runTokeniserBenchmark (const juce::ArgumentList& args)
+{
+    auto generatedSize = (size_t) (getNumberOption (args, "--size", 4.0) * 1024 * 1024);
+    auto numRepeats = juce::jmax (1, (int) getNumberOption (args, "--repeats", 10));
+
+    std::vector<soul::CodeLocation> sources;
+    sources.push_back (soul::Compiler::getBuiltInLibraryCode());
+    sources.push_back (soul::CodeLocation::createFromString ("Generated", createTokeniserTestCode (generatedSize)));
+
+    for (auto& arg : args.arguments)
+        if (! arg.isOption() && arg.resolveAsFile().hasFileExtension (".soul"))
+            sources.push_back (soul::CodeLocation::createFromString (arg.resolveAsFile().getFileName().toStdString(),
+                                                                     arg.resolveAsFile().loadFileAsString().toStdString()));
+
+    std::cout << "Source                       Size (KB)     Tokens      MB/s   Mtokens/s" << std::endl;
+
+    for (auto& source : sources)
+    {
+        auto numBytes = (double) source.sourceCode->content.size();
+        double bestSeconds = 0;
+        size_t numTokens = 0;
+
+        for (int i = 0; i < numRepeats; ++i)
+        {
+            soul::CompileMessageList messages;
+            auto start = std::chrono::steady_clock::now();
+            numTokens = soul::Compiler::countTokens (messages, source);
+            auto seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+            if (messages.hasErrors())
+                juce::ConsoleApplication::fail (messages.toString());
+
+            if (i == 0 || seconds < bestSeconds)
+                bestSeconds = seconds;
+        }
+
+        std::cout << juce::String (source.getFilename()).paddedRight (' ', 24)
+                  << juce::String (numBytes / 1024.0, 1).paddedLeft (' ', 14)
+                  << juce::String ((juce::int64) numTokens).paddedLeft (' ', 11)
+                  << juce::String (numBytes / (bestSeconds * 1024.0 * 1024.0), 1).paddedLeft (' ', 10)
+                  << juce::String ((double) numTokens / (bestSeconds * 1.0e6), 2).paddedLeft (' ', 12) << std::endl;
+    }
+}
+
+//==============================================================================
+/** Finds the .soul files that the command-line arguments refer to. Each argument can be a
+    .soul file, or a JSON list of them such as examples/standalone/examples.json.
+*/
+static juce::Array<juce::File> findSOULFiles (const juce::ArgumentList& args)
+{
+    juce::Array<juce::File> files;
+
+    for (auto& arg : args.arguments)
+    {
+        if (arg.isOption())
+            continue;
+
+        auto file = arg.resolveAsFile();
+
+        if (file.hasFileExtension (".soul"))
+        {
+            files.add (file);
+        }
+        else if (file.hasFileExtension (".json"))
+        {
+            auto list = juce::JSON::parse (file);
+
+            if (! list.isArray())
+                juce::ConsoleApplication::fail ("Expected " + file.getFullPathName() + " to contain a list of files");
+
+            for (auto& item : *list.getArray())
+                files.add (file.getSiblingFile (item.toString()));
+        }
+        else
+        {
+            juce::ConsoleApplication::fail ("Don't know what to do with " + file.getFullPathName());
+        }
+    }
+
+    if (files.isEmpty())
+        juce::ConsoleApplication::fail ("No .soul files were given");
+
+    return files;
+}
+
+/** If the given option was used, writes some profiler output to the file that it names. */
+static void writeProfile (const juce::ArgumentList& args, const char* option, const std::string& content)
+{
+    if (args.containsOption (option))
+    {
+        auto file = args.getFileForOption (option);
+
+        if (! file.replaceWithText (content))
+            juce::ConsoleApplication::fail ("Couldn't write to " + file.getFullPathName());
+
+        std::cout << "Wrote " << file.getFullPathName() << std::endl;
+    }
+}
+
+/** Builds some programs many times over on a BatchCompiler, and checks that every result
+    matches the one that a Compiler produces for the same code on the calling thread.
+
+    The programs are compared using their HEART code and compile messages. This is meant to
+    be run in a build with ThreadSanitizer enabled, which will report any races between the
+    compiler's threads, while the comparison catches any that corrupt the results.
+
+    The serial builds are profiled with a CompileProfiler, and the results can be saved with
+    --profile (as JSON, to compare with earlier runs) and --trace (for chrome://tracing).
+*/
+static void runCompilerStressTest (const juce::ArgumentList& args)
+{
+    auto numThreads = (uint32_t) juce::jmax (0, (int) getNumberOption (args, "--threads", 0));
+    auto numRepeats = juce::jmax (1, (int) getNumberOption (args, "--repeats", 8));
+
+    struct Source
+    {
+        juce::String name;
+        soul::CodeLocation code;
+        std::string heart, messages;
+    };
+
+    soul::LinkOptions linkOptions;
+    std::vector<Source> sources;
+
+    {
+        // A profiler only sees the thread that created it, so it records the serial builds,
+        // each as a top-level phase named after its file
+        soul::CompileProfiler profiler;
+
+        for (auto& file : findSOULFiles (args))
+        {
+            Source source;
+            source.name = file.getFileName();
+            source.code = soul::CodeLocation::createFromString (file.getFullPathName().toStdString(),
+                                                                file.loadFileAsString().toStdString());
+
+            soul::CompileMessageList messages;
+            soul::Program program;
+
+            {
+                soul::CompileProfiler::ScopedPhase phase (source.name.toRawUTF8());
+                program = soul::Compiler::build (messages, source.code, linkOptions);
+            }
+
+            source.heart = program ? program.toHEART() : std::string();
+            source.messages = messages.toString();
+            sources.push_back (std::move (source));
+        }
+
+        writeProfile (args, "--profile", profiler.toJSON());
+        writeProfile (args, "--trace", profiler.toChromeTrace());
+    }
+
+    std::vector<soul::BatchCompiler::Job> jobs;
+
+    for (int i = 0; i < numRepeats; ++i)
+        for (auto& source : sources)
+            jobs.push_back ({ { source.code }, linkOptions });
+
+    soul::BatchCompiler compiler (numThreads);
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = compiler.compile (jobs);
+    auto seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+    int numMismatches = 0;
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& source = sources[i % sources.size()];
+        auto& result = results[i];
+
+        if (result.messages.toString() != source.messages
+             || (result.program ? result.program.toHEART() : std::string()) != source.heart)
+        {
+            std::cout << source.name << ": build " << (i / sources.size() + 1) << " doesn't match the serial build" << std::endl;
+            ++numMismatches;
+        }
+    }
+
+    std::cout << results.size() << " builds of " << sources.size() << " programs took " << juce::String (seconds, 2) << "s" << std::endl;
+
+    if (numMismatches != 0)
+        juce::ConsoleApplication::fail (juce::String (numMismatches) + " builds didn't match the serial build");
+
+    std::cout << "All builds matched the serial build" << std::endl;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand ("--help|-h", "Usage: SOULPatchBenchmark <command> [--library=<patch loader library>] [options]", true);
+
+    app.addCommand ({ "--benchmark",
+                      "--benchmark [--rates=<list>] [--blocks=<list>] [--seconds=<n>] [--output=<file>] [--baseline=<file> [--tolerance=<n>]] <patches...>",
+                      "Builds and renders each patch at a range of sample rates and block sizes",
+                      "Each patch argument can be a .soulpatch file, a folder to search for them, a .soul file, or a JSON "
+                      "file containing a list of .soul files, like examples/standalone/examples.json.\n"
+                      "The results can be saved as JSON with --output. If a previous set of results is given with "
+                      "--baseline, the app fails if any run has got slower by more than the tolerance, which defaults to 0.1.",
+                      [] (const juce::ArgumentList& args) { runBenchmark (args); } });
+
+    app.addCommand ({ "--parameters",
+                      "--parameters [--counts=<list>] [--rate=<n>] [--block=<n>] [--seconds=<n>]",
+                      "Measures the render overhead of patches with increasing numbers of parameters",
+                      "A patch is generated for each of the parameter counts, and the average time spent in each render "
+                      "call is printed for when no parameters change, when one changes before each block, and when they "
+                      "all change before each block.",
+                      [] (const juce::ArgumentList& args) { runParameterCountBenchmark (args); } });
+
+    app.addCommand ({ "--first-audio",
+                      "--first-audio [--instances=<list>] [--rate=<n>] [--block=<n>] [--timeout=<seconds>] <patches...>",
+                      "Measures the time it takes a number of processors to build their players and render audio",
+                      "For each patch and instance count, that many SOULPatchAudioProcessors are created at once, and "
+                      "the times at which the first, median and last of them rendered their first block are printed.",
+                      [] (const juce::ArgumentList& args) { runTimeToFirstAudioBenchmark (args); } });
+
+    app.addCommand ({ "--fast-math",
+                      "--fast-math [--values=<n>]",
+                      "Compares the accuracy and speed of the fastMath approximations with the standard functions",
+                      "Each function is built once as a normal processor and once with a fastMath annotation, for scalars "
+                      "and 4-lane vectors. A sweep of values across the range that its error bound is documented for is "
+                      "sent through both builds, and the largest error against the float64 std:: version, and the average "
+                      "render time per value, are printed for each.",
+                      [] (const juce::ArgumentList& args) { runFastMathBenchmark (args); } });
+
+    app.addCommand ({ "--resample",
+                      "--resample [--channels=<n>] [--seconds=<n>] [--from=<rate>] [--to=<rate>] [--skip-patch]",
+                      "Measures how quickly external audio data is resampled when a patch is loaded",
+                      "Some noise is resampled with resampleToFit(), and with fastResampleToFit() on one thread and "
+                      "across a ThreadPool, and the time taken and throughput of each are printed. The noise is then "
+                      "written to a WAV file and loaded as an external by two generated patches, one of which has a "
+                      "'resample' annotation, and the time taken to load and build each of them is printed. Use "
+                      "--skip-patch to leave out the second part, which needs the patch loader library.",
+                      [] (const juce::ArgumentList& args) { runResampleBenchmark (args); } });
+
+    app.addCommand ({ "--allocations",
+                      "--allocations [--rate=<n>] [--block=<n>] [--swaps=<n>] [--timeout=<seconds>]",
+                      "Checks that a SOULPatchAudioProcessor's processBlock doesn't allocate any memory",
+                      "A generated patch with a parameter, MIDI input and an audio input is played on an audio thread, "
+                      "which changes the parameter and sends MIDI before each block, while its source is rewritten so "
+                      "that the player is rebuilt and hot-swapped the given number of times. The app's operator new and "
+                      "delete count any calls made inside processBlock, and the command fails if there were any. On macOS "
+                      "and Windows, allocations made inside the patch loader library itself can't be seen this way.",
+                      [] (const juce::ArgumentList& args) { runAllocationTest (args); } });
+
+    app.addCommand ({ "--tokeniser",
+                      "--tokeniser [--size=<MB>] [--repeats=<n>] [<.soul files...>]",
+                      "Measures the speed of the compiler's tokeniser",
+                      "The built-in library, a generated source file of the given size and any .soul files given are "
+                      "each split into tokens the given number of times, and the fastest run's throughput is printed "
+                      "in MB/s and millions of tokens per second.",
+                      [] (const juce::ArgumentList& args) { runTokeniserBenchmark (args); } });
+
+    app.addCommand ({ "--stress",
+                      "--stress [--threads=<n>] [--repeats=<n>] [--profile=<file>] [--trace=<file>] <.soul files...>",
+                      "Builds some programs many times in parallel, and checks that the results match a serial build",
+                      "Each argument can be a .soul file or a JSON file containing a list of them, like "
+                      "examples/standalone/examples.json. Each program is built once on the main thread, and then the "
+                      "given number of times on a BatchCompiler with the given number of threads (one per core by "
+                      "default), and the command fails if any of the parallel builds' HEART code or compile messages "
+                      "differ. Run it in a build with ThreadSanitizer enabled to check for data races.\n"
+                      "The time and memory used by each phase of the first, serial, build of each program can be written "
+                      "to a file as JSON with --profile, or as a trace for chrome://tracing or Perfetto with --trace.",
+                      [] (const juce::ArgumentList& args) { runCompilerStressTest (args); } });
+
+    return app.findAndRunCommand (argc, argv);
+}
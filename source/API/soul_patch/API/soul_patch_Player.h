@@ -87,6 +87,18 @@ struct PatchPlayerConfiguration
 {
     double sampleRate = 0;
     uint32_t maxFramesPerBlock = 0;
+
+    /** If this is greater than 1, the patch will be run internally at this multiple
+        of the sample rate, and its audio i/o will be resampled to and from the host rate.
+        This lets non-linear patches oversample without needing to do it themselves.
+    */
+    uint32_t oversamplingFactor = 1;
+
+    /** If this is non-zero, the patch will be run internally at this fixed rate, whatever
+        the value of sampleRate, and its audio i/o will be resampled to and from the host
+        rate. If set, this takes precedence over the oversamplingFactor.
+    */
+    double internalSampleRate = 0;
 };
 
 //==============================================================================
@@ -191,6 +203,13 @@ public:
         MIDI data that is needed.
     */
     virtual RenderResult render (const RenderContext&) = 0;
+
+    /** Returns the number of frames by which the player delays its output. This is only
+        non-zero when the patch is run internally at a different rate to the host, in which
+        case it's the delay added by the resampling filters, and a host should compensate for it.
+        @see PatchPlayerConfiguration::oversamplingFactor, PatchPlayerConfiguration::internalSampleRate
+    */
+    virtual uint32_t getLatencyInFrames() const = 0;
 };
 
 } // namespace patch
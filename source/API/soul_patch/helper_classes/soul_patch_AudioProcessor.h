@@ -14,6 +14,7 @@
 #endif
 
 #include "../API/soul_patch.h"
+#include "soul_patch_CompileService.h"
 
 namespace soul
 {
@@ -29,11 +30,11 @@ namespace patch
 
     NOTE: Unlike a normal AudioProcessor, you also need to provide a callback
     function using the askHostToReinitialise parameter - the object will
-    use its own background thread to recompile the SOUL code, and will use
-    this callback to tell the host when its configuration has changed.
+    use the shared PatchCompileService to recompile the SOUL code in the
+    background, and will use this callback to tell the host when its
+    configuration has changed.
 */
 struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
-                                    private juce::Thread,
                                     private juce::AsyncUpdater
 {
     /** Creates a SOULPatchAudioProcessor from a PatchInstance. */
@@ -41,19 +42,26 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
                              soul::patch::CompilerCache::Ptr compilerCache = {},
                              soul::patch::SourceFilePreprocessor::Ptr sourcePreprocessor = {},
                              soul::patch::ExternalDataProvider::Ptr externalDataProvider = {})
-       : juce::Thread ("SOUL Compiler"),
-         patch (std::move (patchToLoad)),
+       : patch (std::move (patchToLoad)),
          cache (std::move (compilerCache)),
          preprocessor (std::move (sourcePreprocessor)),
-         externalData (externalDataProvider)
+         externalData (externalDataProvider),
+         compileService (PatchCompileService::getSharedInstance()),
+         builder (std::make_shared<PlayerBuilder> (*this))
     {
         jassert (patch != nullptr);
-        startThread (3);
+        compileService->addClient (builder);
     }
 
     ~SOULPatchAudioProcessor() override
     {
-        stopThread (100000);
+        // If a build is running, this doesn't wait for it: it carries on without us, and its result is discarded.
+        // The exception is when this is the last processor using the compile service: releasing the service
+        // deletes it, which waits for its worker threads to finish their jobs and stop, so that no code from
+        // this module can still be running once the host has deleted all its processors.
+        builder->detachFromOwner();
+        compileService->removeClient (*builder);
+        cancelPendingUpdate();
         player = {};
         patch = {};
     }
@@ -72,9 +80,13 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
         parameter list and other properties. After calling reinitialise(), the host
         can call prepareToPlay again and start playing the processor again.
 
-        The processor has its own background thread that re-compiles new SOUL patch
-        code behind the scenes while the plugin is still running, and once it has a
-        new build ready, it triggers a call to this function from the message thread.
+        The processor uses the PatchCompileService's worker threads to re-compile new
+        SOUL patch code behind the scenes while the plugin is still running, and once it
+        has a new build ready, it triggers a call to this function from the message thread.
+
+        If the new build has the same buses and parameters as the old one, the processor
+        doesn't need the host's help: it swaps the new player in while audio is running
+        (see setHotSwapCrossfadeLength()), and this callback isn't used.
     */
     std::function<void()> askHostToReinitialise;
 
@@ -91,12 +103,29 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
         description = desc.description;
         showMIDIKeyboard = desc.isInstrument;
 
-        if (replacementPlayer != nullptr)
+        bool playerChanged = false;
+
         {
-            applyLastStateToPlayer (*replacementPlayer);
-            player = std::move (replacementPlayer);
-            refreshParameterList();
+            const juce::ScopedLock sl (swapLock);
+
+            if (replacementPlayer != nullptr)
+            {
+                applyLastStateToPlayer (*replacementPlayer);
+                player = std::move (replacementPlayer);
+                playerChanged = true;
+            }
         }
+
+        if (playerChanged)
+            refreshParameterList();
+
+        if (player != nullptr)
+            setLatencySamples ((int) player->getLatencyInFrames());
+
+        resetAudioThreadPlayers();
+
+        // in case the configuration changed while the last build was in progress
+        requestCompile();
     }
 
     /** Returns a string containing all the compile messages and warnings, or an empty string if
@@ -115,6 +144,41 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
         return errors.joinIntoString ("\n");
     }
 
+    /** Sets the rate at which the patch should run internally, relative to the host.
+        The player will be rebuilt in the background if this changes.
+        @see PatchPlayerConfiguration::oversamplingFactor, PatchPlayerConfiguration::internalSampleRate
+    */
+    void setInternalSampleRate (uint32_t oversamplingFactor, double fixedInternalSampleRate = 0)
+    {
+        {
+            const juce::ScopedLock sl (configLock);
+            currentConfig.oversamplingFactor = oversamplingFactor;
+            currentConfig.internalSampleRate = fixedInternalSampleRate;
+        }
+
+        requestCompile();
+    }
+
+    /** Sets the length of the crossfade which is used when a rebuilt player is swapped in
+        while the processor is running. A length of zero makes it switch immediately.
+    */
+    void setHotSwapCrossfadeLength (double seconds)
+    {
+        const juce::ScopedLock sl (configLock);
+        hotSwapCrossfadeSeconds = std::max (0.0, seconds);
+    }
+
+    /** Sets the priority with which this processor's builds are scheduled by the
+        PatchCompileService, relative to other instances. A host could raise this for
+        tracks that are visible or selected. Processors which have an editor open are
+        also given a small boost.
+    */
+    void setCompilePriority (int newPriority)
+    {
+        compilePriority = newPriority;
+        requestCompile();
+    }
+
     /** Returns true if the patch compiled with no errors and can be played */
     bool isPlayable() const
     {
@@ -216,13 +280,21 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
     //==============================================================================
     void prepareToPlay (double sampleRate, int maxBlockSize) override
     {
-        const juce::ScopedLock sl (configLock);
-        currentConfig = { sampleRate, (uint32_t) maxBlockSize };
-        messageSpace.resize (1024);
-        preprocessInputData = nullptr;
-        postprocessOutputData = nullptr;
+        {
+            const juce::ScopedLock sl (configLock);
+            currentConfig.sampleRate = sampleRate;
+            currentConfig.maxFramesPerBlock = (uint32_t) maxBlockSize;
+        }
+
+        requestCompile();
+
+        resetAudioThreadPlayers();
+        isPrepared = true;
+
         numPatchInputChannels = 0;
         numPatchOutputChannels = 0;
+        inputAdaptation = ChannelAdaptation::none;
+        outputAdaptation = ChannelAdaptation::none;
         setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
         midiKeyboardState.reset();
 
@@ -230,100 +302,72 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
         {
             numPatchInputChannels  = countTotalBusChannels (player->getInputBuses());
             numPatchOutputChannels = countTotalBusChannels (player->getOutputBuses());
+            setLatencySamples ((int) player->getLatencyInFrames());
 
             auto pluginBuses = getBusesLayout();
 
             // We'll do some fairly rough heuristics here to handle simple
             // stereo<->mono conversion situations
-
-            auto monoToStereo = [] (juce::AudioBuffer<float>& b) { b.copyFrom (1, 0, b, 0, 0, b.getNumSamples()); };
-            auto stereoToMono = [] (juce::AudioBuffer<float>& b) { b.addFrom  (0, 0, b, 1, 0, b.getNumSamples()); };
-
-            if (numPatchInputChannels == 1 && pluginBuses.getMainInputChannels() == 2)
-                preprocessInputData = stereoToMono;
-
-            if (numPatchInputChannels == 2 && pluginBuses.getMainInputChannels() == 1)
-                preprocessInputData = monoToStereo;
-
-            if (numPatchOutputChannels == 1 && pluginBuses.getMainOutputChannels() == 2)
-                postprocessOutputData = monoToStereo;
-
-            if (numPatchOutputChannels == 2 && pluginBuses.getMainOutputChannels() == 1)
-                postprocessOutputData = stereoToMono;
+            if (numPatchInputChannels == 1 && pluginBuses.getMainInputChannels() == 2)    inputAdaptation  = ChannelAdaptation::stereoToMono;
+            if (numPatchInputChannels == 2 && pluginBuses.getMainInputChannels() == 1)    inputAdaptation  = ChannelAdaptation::monoToStereo;
+            if (numPatchOutputChannels == 1 && pluginBuses.getMainOutputChannels() == 2)  outputAdaptation = ChannelAdaptation::monoToStereo;
+            if (numPatchOutputChannels == 2 && pluginBuses.getMainOutputChannels() == 1)  outputAdaptation = ChannelAdaptation::stereoToMono;
         }
+
+        // Everything the audio thread needs is allocated here, so that processBlock never has to
+        maxFramesPerChunk = juce::jmax (1, maxBlockSize);
+        inputScratch.setSize (juce::jmax (1, numPatchInputChannels), maxFramesPerChunk);
+        outputScratch.setSize (juce::jmax (1, numPatchOutputChannels), maxFramesPerChunk);
+        fadingOutputBuffer.setSize (juce::jmax (1, numPatchOutputChannels), maxFramesPerChunk);
+        outputChannelPointers.resize ((size_t) juce::jmax (1, numPatchOutputChannels));
+        messageSpace.resize (1024);
     }
 
     void releaseResources() override
     {
+        isPrepared = false;
+        resetAudioThreadPlayers();
         reset();
         midiKeyboardState.reset();
     }
 
     using juce::AudioProcessor::processBlock;
 
+    /** Renders the patch without allocating or locking.
+
+        The patch's outputs are rendered straight into the host's buffer when it has enough
+        channels. Its inputs are copied to a scratch buffer first, because the host's buffer
+        is also where the outputs go, and the player doesn't promise to read all its input
+        before writing any output. A block which is longer than the size given to prepareToPlay,
+        or which has more MIDI messages than there's room for, is rendered in several chunks.
+    */
     void processBlock (juce::AudioBuffer<float>& audio, juce::MidiBuffer& midi) override
     {
         auto numFrames = audio.getNumSamples();
-        auto numOutputChannels = getTotalNumOutputChannels();
-        outputBuffer.setSize (numOutputChannels, numFrames, false, false, true);
-        outputBuffer.clear();
-
-        if (! (isSuspended() || player == nullptr))
-        {
-            if (preprocessInputData != nullptr)
-                preprocessInputData (audio);
 
-            soul::patch::PatchPlayer::RenderContext rc;
+        if (auto newPlayer = nextPlayer.exchange (nullptr))
+            startPlayerSwap (*newPlayer);
 
-            rc.inputChannels = audio.getArrayOfReadPointers();
-            rc.numInputChannels = (uint32_t) juce::jmin (numPatchInputChannels, audio.getNumChannels());
-            rc.outputChannels = outputBuffer.getArrayOfWritePointers();
-            rc.numOutputChannels = (uint32_t) juce::jmin (numPatchOutputChannels, outputBuffer.getNumChannels());
-            rc.numFrames = (uint32_t) numFrames;
-            rc.incomingMIDI = std::addressof (messageSpace[0]);
-            rc.numMIDIMessages = 0;
+        midiKeyboardState.processNextMidiBuffer (midi, 0, numFrames, true);
 
-            midiKeyboardState.processNextMidiBuffer (midi, 0, numFrames, true);
-
-            if (! midi.isEmpty())
-            {
-                auto maxEvents = messageSpace.size();
-
-                juce::MidiBuffer::Iterator iter (midi);
-                size_t i = 0;
-
-                while (i < maxEvents)
-                {
-                    const juce::uint8* midiData;
-                    int numBytesOfMidiData, samplePosition;
-
-                    if (! iter.getNextEvent (midiData, numBytesOfMidiData, samplePosition))
-                        break;
-
-                    if (numBytesOfMidiData < 4)
-                    {
-                        auto& m = messageSpace[i++];
-
-                        m.frameIndex = (uint32_t) samplePosition;
-                        m.byte0 = (uint8_t) midiData[0];
-                        m.byte1 = (uint8_t) midiData[1];
-                        m.byte2 = (uint8_t) midiData[2];
-                    }
-                }
+        if (isSuspended() || renderingPlayer == nullptr)
+        {
+            audio.clear();
+            midi.clear();
+            return;
+        }
 
-                rc.numMIDIMessages = (uint32_t) i;
-                midi.clear();
-            }
+        MIDIEventReader midiReader (midi);
 
-            auto result = player->render (rc);
-            juce::ignoreUnused (result);
+        for (int chunkStart = 0; chunkStart < numFrames;)
+        {
+            uint32_t numMessages = 0;
+            auto chunkEnd = readMIDIMessages (midiReader, chunkStart, juce::jmin (numFrames, chunkStart + maxFramesPerChunk), numMessages);
+            renderChunk (audio, chunkStart, chunkEnd - chunkStart, numMessages);
+            chunkStart = chunkEnd;
         }
 
-        for (int i = 0; i < outputBuffer.getNumChannels(); ++i)
-            audio.copyFrom (i, 0, outputBuffer, i, 0, numFrames);
-
-        if (postprocessOutputData != nullptr)
-            postprocessOutputData (audio);
+        midi.clear();
     }
 
     //==============================================================================
@@ -414,10 +458,20 @@ struct SOULPatchAudioProcessor    : public juce::AudioPluginInstance,
     bool isMidiEffect() const override                      { return false; }
 
     //==============================================================================
+    /** The host never calls this at the same time as processBlock(), so it only touches the
+        players that the audio thread is using, rather than the ones which the message thread
+        may be swapping. Any crossfade in progress is cut short.
+    */
     void reset() override
     {
-        if (player != nullptr)
-            player->reset();
+        if (renderingPlayer != nullptr)
+            renderingPlayer->reset();
+
+        if (fadingOutPlayer != nullptr)
+        {
+            fadingOutPlayer = nullptr;
+            fadingOutPlayerFinished = true;
+        }
     }
 
     //==============================================================================
@@ -431,15 +485,35 @@ private:
 
     juce::String name, description;
 
-    soul::patch::PatchPlayer::Ptr player, replacementPlayer;
+    soul::patch::PatchPlayer::Ptr player, replacementPlayer, retiringPlayer;
 
-    juce::CriticalSection configLock;
-    soul::patch::PatchPlayerConfiguration currentConfig;
+    PatchCompileService::Ptr compileService;
+
+    struct PlayerBuilder;
+    std::shared_ptr<PlayerBuilder> builder;
 
-    juce::AudioBuffer<float> outputBuffer;
+    juce::CriticalSection configLock, swapLock;
+    soul::patch::PatchPlayerConfiguration currentConfig;
+    std::atomic<int> compilePriority { 0 };
+    double hotSwapCrossfadeSeconds = 0.02, swapStartTime = 0;
+    bool isPrepared = false;
+
+    // These are used to hand a new player over to the audio thread without the host stopping it
+    std::atomic<soul::patch::PatchPlayer*> nextPlayer { nullptr };
+    std::atomic<uint32_t> nextCrossfadeLengthFrames { 0 };
+    std::atomic<bool> fadingOutPlayerFinished { false };
+    soul::patch::PatchPlayer* renderingPlayer = nullptr;
+    soul::patch::PatchPlayer* fadingOutPlayer = nullptr;
+    uint32_t crossfadeLengthFrames = 0, crossfadeFramesDone = 0;
+    juce::AudioBuffer<float> fadingOutputBuffer;
+
+    enum class ChannelAdaptation { none, monoToStereo, stereoToMono };
+
+    juce::AudioBuffer<float> inputScratch, outputScratch;
+    std::vector<float*> outputChannelPointers;
     std::vector<soul::patch::MIDIMessage> messageSpace;
-    int numPatchInputChannels = 0, numPatchOutputChannels = 0;
-    std::function<void(juce::AudioBuffer<float>&)> preprocessInputData, postprocessOutputData;
+    int numPatchInputChannels = 0, numPatchOutputChannels = 0, maxFramesPerChunk = 1;
+    ChannelAdaptation inputAdaptation = ChannelAdaptation::none, outputAdaptation = ChannelAdaptation::none;
 
     juce::MidiKeyboardState midiKeyboardState;
     bool showMIDIKeyboard = false;
@@ -465,6 +539,12 @@ private:
         return currentConfig;
     }
 
+    double getHotSwapCrossfadeSeconds() const
+    {
+        const juce::ScopedLock sl (configLock);
+        return hotSwapCrossfadeSeconds;
+    }
+
     static bool getFlagState (const soul::patch::Parameter& param, const char* flagName, bool defaultState)
     {
         if (auto flag = param.getProperty (flagName))
@@ -488,40 +568,395 @@ private:
     }
 
     //==============================================================================
-    void run() override
+    void requestCompile()
+    {
+        compileService->requestCompile (*builder, compilePriority + (getActiveEditor() != nullptr ? 1 : 0));
+    }
+
+    struct BuildSettings
+    {
+        soul::patch::PatchInstance::Ptr patch;
+        soul::patch::CompilerCache::Ptr cache;
+        soul::patch::SourceFilePreprocessor::Ptr preprocessor;
+        soul::patch::ExternalDataProvider::Ptr externalData;
+        soul::patch::PatchPlayerConfiguration config;
+    };
+
+    /** The object that the compile service runs build jobs for. This is separate from the
+        processor, and only holds a pointer to it while a job is gathering its settings or
+        handing over the result, so the processor can be deleted without waiting for the
+        build in between to finish.
+    */
+    struct PlayerBuilder  : public PatchCompileService::Client
     {
-        while (! threadShouldExit())
+        PlayerBuilder (SOULPatchAudioProcessor& o) : owner (std::addressof (o)) {}
+
+        void performCompileJob() override
         {
-            if (replacementPlayer == nullptr)
+            BuildSettings settings;
+
             {
-                auto config = getConfigCopy();
+                std::lock_guard<std::mutex> l (ownerLock);
 
-                if (config.sampleRate != 0 && config.maxFramesPerBlock != 0)
-                {
-                    if (player == nullptr || player->needsRebuilding (currentConfig))
-                    {
-                        auto newPlayer = patch->compileNewPlayer (currentConfig, cache.get(),
-                                                                  preprocessor.get(), externalData.get());
+                if (owner == nullptr || ! owner->getSettingsForNewBuild (settings))
+                    return;
+            }
 
-                        if (threadShouldExit())
-                            return;
+            auto newPlayer = settings.patch->compileNewPlayer (settings.config, settings.cache.get(),
+                                                               settings.preprocessor.get(),
+                                                               settings.externalData.get());
 
-                        replacementPlayer = newPlayer;
-                        triggerAsyncUpdate();
-                    }
-                }
-            }
+            std::lock_guard<std::mutex> l (ownerLock);
+
+            if (owner != nullptr)
+                owner->setReplacementPlayer (std::move (newPlayer));
+        }
+
+        void detachFromOwner()
+        {
+            std::lock_guard<std::mutex> l (ownerLock);
+            owner = nullptr;
+        }
+
+        std::mutex ownerLock;
+        SOULPatchAudioProcessor* owner;
+    };
+
+    /** Called on a worker thread to find out whether a new build is needed, and if so,
+        to take a copy of everything that it'll need.
+    */
+    bool getSettingsForNewBuild (BuildSettings& settings)
+    {
+        retireOldPlayerIfFinished();
 
-            wait (1000);
+        soul::patch::PatchPlayer::Ptr currentPlayer;
+
+        {
+            const juce::ScopedLock sl (swapLock);
+
+            if (replacementPlayer != nullptr)
+                return false;
+
+            currentPlayer = player;
         }
+
+        settings.config = getConfigCopy();
+
+        if (settings.config.sampleRate == 0 || settings.config.maxFramesPerBlock == 0)
+            return false;
+
+        if (currentPlayer != nullptr && ! currentPlayer->needsRebuilding (settings.config))
+            return false;
+
+        settings.patch = patch;
+        settings.cache = cache;
+        settings.preprocessor = preprocessor;
+        settings.externalData = externalData;
+        return true;
+    }
+
+    void setReplacementPlayer (soul::patch::PatchPlayer::Ptr newPlayer)
+    {
+        const juce::ScopedLock sl (swapLock);
+        replacementPlayer = std::move (newPlayer);
+        triggerAsyncUpdate();
     }
 
     void handleAsyncUpdate() override
     {
+        if (swapPlayerWhileRunning())
+            return;
+
         if (askHostToReinitialise != nullptr)
             askHostToReinitialise();
     }
 
+    //==============================================================================
+    /** Called on the message thread to hand a new build to the audio thread, if it's
+        similar enough to the current one that the host doesn't need to know about it.
+        Returns false if the host needs to reinitialise the processor instead.
+    */
+    bool swapPlayerWhileRunning()
+    {
+        const juce::ScopedLock sl (swapLock);
+
+        if (replacementPlayer == nullptr || ! isPrepared || ! canSwapWhileRunning (*replacementPlayer))
+            return false;
+
+        // If a previous swap is still in progress, this will be retried once it's done. But if
+        // the audio thread has stopped without the host releasing the processor, that'll never
+        // happen, so after a while the host is asked to reinitialise it instead.
+        if (retiringPlayer != nullptr)
+            return ! hasPlayerSwapStalled();
+
+        // This copies the hidden parameters, and rebinding the visible ones then copies
+        // across any values that the host has set on them since
+        updateLastState();
+        applyLastStateToPlayer (*replacementPlayer);
+
+        retiringPlayer = std::move (player);
+        player = std::move (replacementPlayer);
+
+        for (auto* p : getParameters())
+            if (auto* patchParam = dynamic_cast<PatchParameter*> (p))
+                for (auto& newParam : player->getParameters())
+                    if (newParam->ID.toString<juce::String>() == patchParam->paramID)
+                        patchParam->rebind (newParam);
+
+        swapStartTime = juce::Time::getMillisecondCounterHiRes();
+        nextCrossfadeLengthFrames = (uint32_t) (getHotSwapCrossfadeSeconds() * getSampleRate());
+        nextPlayer = player.get();
+        return true;
+    }
+
+    /** True if the audio thread has taken much longer than the crossfade to finish a swap. */
+    bool hasPlayerSwapStalled() const
+    {
+        auto timeoutMs = 1000.0 * std::max (1.0, 4.0 * getHotSwapCrossfadeSeconds());
+        return juce::Time::getMillisecondCounterHiRes() > swapStartTime + timeoutMs;
+    }
+
+    bool canSwapWhileRunning (soul::patch::PatchPlayer& newPlayer) const
+    {
+        if (player == nullptr || ! (player->isPlayable() && newPlayer.isPlayable()))
+            return false;
+
+        auto haveSameChannels = [] (Span<soul::patch::Bus> oldBuses, Span<soul::patch::Bus> newBuses)
+        {
+            if (oldBuses.size() != newBuses.size())
+                return false;
+
+            for (uint32_t i = 0; i < oldBuses.size(); ++i)
+                if (oldBuses[i].numChannels != newBuses[i].numChannels)
+                    return false;
+
+            return true;
+        };
+
+        auto getParameterSignatures = [] (soul::patch::PatchPlayer& p)
+        {
+            juce::StringArray result;
+
+            for (auto& param : p.getParameters())
+            {
+                juce::String sig;
+                sig << param->ID.toString<juce::String>() << ":" << param->name.toString<juce::String>()
+                    << ":" << param->unit.toString<juce::String>() << ":" << param->minValue << ":" << param->maxValue
+                    << ":" << param->step << ":" << param->initialValue;
+
+                for (auto propertyName : param->getPropertyNames())
+                    sig << ":" << propertyName << "=" << param->getProperty (propertyName).toString<juce::String>();
+
+                result.add (sig);
+            }
+
+            return result;
+        };
+
+        // A change of latency has to be reported to the host, so can't happen while it's running
+        return haveSameChannels (player->getInputBuses(), newPlayer.getInputBuses())
+            && haveSameChannels (player->getOutputBuses(), newPlayer.getOutputBuses())
+            && player->getLatencyInFrames() == newPlayer.getLatencyInFrames()
+            && getParameterSignatures (*player) == getParameterSignatures (newPlayer);
+    }
+
+    /** Called on a worker thread to delete the old player once the audio thread has stopped using it. */
+    void retireOldPlayerIfFinished()
+    {
+        const juce::ScopedLock sl (swapLock);
+
+        if (retiringPlayer != nullptr && fadingOutPlayerFinished.exchange (false))
+        {
+            retiringPlayer = {};
+
+            if (replacementPlayer != nullptr)
+                triggerAsyncUpdate();
+        }
+        else if (retiringPlayer != nullptr && replacementPlayer != nullptr && hasPlayerSwapStalled())
+        {
+            triggerAsyncUpdate();
+        }
+    }
+
+    /** Only called when the audio thread isn't running. */
+    void resetAudioThreadPlayers()
+    {
+        const juce::ScopedLock sl (swapLock);
+        nextPlayer = nullptr;
+        renderingPlayer = player.get();
+        fadingOutPlayer = nullptr;
+        fadingOutPlayerFinished = false;
+        retiringPlayer = {};
+    }
+
+    void startPlayerSwap (soul::patch::PatchPlayer& newPlayer)
+    {
+        fadingOutPlayer = renderingPlayer;
+        renderingPlayer = std::addressof (newPlayer);
+        crossfadeLengthFrames = nextCrossfadeLengthFrames;
+        crossfadeFramesDone = 0;
+
+        if (fadingOutPlayer == nullptr || crossfadeLengthFrames == 0)
+        {
+            fadingOutPlayer = nullptr;
+            fadingOutPlayerFinished = true;
+        }
+    }
+
+    void renderFadingOutPlayer (soul::patch::PatchPlayer::RenderContext rc)
+    {
+        auto outputChannels = rc.outputChannels;
+
+        for (uint32_t chan = 0; chan < rc.numOutputChannels; ++chan)
+            fadingOutputBuffer.clear ((int) chan, 0, (int) rc.numFrames);
+
+        rc.outputChannels = fadingOutputBuffer.getArrayOfWritePointers();
+
+        auto result = fadingOutPlayer->render (rc);
+        juce::ignoreUnused (result);
+
+        auto numFramesToFade = std::min (rc.numFrames, crossfadeLengthFrames - crossfadeFramesDone);
+        auto gainStep = 1.0f / (float) crossfadeLengthFrames;
+
+        for (uint32_t chan = 0; chan < rc.numOutputChannels; ++chan)
+        {
+            auto dest = outputChannels[chan];
+            auto oldPlayerOutput = fadingOutputBuffer.getReadPointer ((int) chan);
+            auto gain = (float) crossfadeFramesDone * gainStep;
+
+            for (uint32_t i = 0; i < numFramesToFade; ++i)
+            {
+                dest[i] = oldPlayerOutput[i] + gain * (dest[i] - oldPlayerOutput[i]);
+                gain += gainStep;
+            }
+        }
+
+        crossfadeFramesDone += numFramesToFade;
+
+        if (crossfadeFramesDone >= crossfadeLengthFrames)
+        {
+            fadingOutPlayer = nullptr;
+            fadingOutPlayerFinished = true;
+        }
+    }
+
+    //==============================================================================
+    /** Reads the events from a MidiBuffer, keeping hold of the next one so that a block
+        can be split wherever it's needed.
+    */
+    struct MIDIEventReader
+    {
+        MIDIEventReader (const juce::MidiBuffer& b) : iterator (b)    { next(); }
+
+        void next()     { hasEvent = iterator.getNextEvent (data, numBytes, samplePosition); }
+
+        juce::MidiBuffer::Iterator iterator;
+        const juce::uint8* data = nullptr;
+        int numBytes = 0, samplePosition = 0;
+        bool hasEvent = false;
+    };
+
+    /** Fills messageSpace with the events for a chunk of the block, and returns the frame at
+        which the chunk must end. This is earlier than the requested end frame if there are
+        too many events to fit.
+    */
+    int readMIDIMessages (MIDIEventReader& reader, int startFrame, int endFrame, uint32_t& numMessages)
+    {
+        while (reader.hasEvent && reader.samplePosition < endFrame)
+        {
+            if (numMessages == messageSpace.size())
+            {
+                if (reader.samplePosition > startFrame)
+                    return reader.samplePosition;
+
+                // There's no way to deliver this many events on a single frame, so the rest get dropped
+                jassertfalse;
+                reader.next();
+                continue;
+            }
+
+            if (reader.numBytes < 4)
+            {
+                auto& m = messageSpace[numMessages++];
+
+                m.frameIndex = (uint32_t) juce::jmax (0, reader.samplePosition - startFrame);
+                m.byte0 = (uint8_t) reader.data[0];
+                m.byte1 = (uint8_t) reader.data[1];
+                m.byte2 = (uint8_t) reader.data[2];
+            }
+
+            reader.next();
+        }
+
+        return endFrame;
+    }
+
+    void renderChunk (juce::AudioBuffer<float>& audio, int startFrame, int numFrames, uint32_t numMessages)
+    {
+        auto numHostChannels = audio.getNumChannels();
+
+        for (int i = 0; i < numPatchInputChannels; ++i)
+        {
+            auto sourceChannel = inputAdaptation == ChannelAdaptation::monoToStereo ? 0 : i;
+
+            if (sourceChannel < numHostChannels)
+                inputScratch.copyFrom (i, 0, audio, sourceChannel, startFrame, numFrames);
+            else
+                inputScratch.clear (i, 0, numFrames);
+        }
+
+        if (inputAdaptation == ChannelAdaptation::stereoToMono && numHostChannels > 1)
+            inputScratch.addFrom (0, 0, audio, 1, startFrame, numFrames);
+
+        auto renderIntoHostBuffer = numHostChannels >= numPatchOutputChannels;
+
+        for (int i = 0; i < numPatchOutputChannels; ++i)
+            outputChannelPointers[(size_t) i] = renderIntoHostBuffer ? audio.getWritePointer (i, startFrame)
+                                                                     : outputScratch.getWritePointer (i);
+
+        soul::patch::PatchPlayer::RenderContext rc;
+
+        rc.inputChannels = inputScratch.getArrayOfReadPointers();
+        rc.numInputChannels = (uint32_t) numPatchInputChannels;
+        rc.outputChannels = outputChannelPointers.data();
+        rc.numOutputChannels = (uint32_t) numPatchOutputChannels;
+        rc.numFrames = (uint32_t) numFrames;
+        rc.incomingMIDI = messageSpace.data();
+        rc.numMIDIMessages = numMessages;
+
+        if (renderingPlayer->render (rc) != soul::patch::PatchPlayer::RenderResult::ok)
+            for (int i = 0; i < numPatchOutputChannels; ++i)
+                juce::FloatVectorOperations::clear (outputChannelPointers[(size_t) i], numFrames);
+
+        if (fadingOutPlayer != nullptr)
+            renderFadingOutPlayer (rc);
+
+        if (! renderIntoHostBuffer)
+        {
+            for (int i = 0; i < numHostChannels; ++i)
+                audio.copyFrom (i, startFrame, outputScratch, i, 0, numFrames);
+
+            if (outputAdaptation == ChannelAdaptation::stereoToMono)
+                audio.addFrom (0, startFrame, outputScratch, 1, 0, numFrames);
+
+            return;
+        }
+
+        auto firstUnusedChannel = numPatchOutputChannels;
+
+        if (outputAdaptation == ChannelAdaptation::stereoToMono)
+            audio.addFrom (0, startFrame, audio, 1, startFrame, numFrames);
+
+        if (outputAdaptation == ChannelAdaptation::monoToStereo && numHostChannels > 1)
+        {
+            audio.copyFrom (1, startFrame, audio, 0, startFrame, numFrames);
+            firstUnusedChannel = 2;
+        }
+
+        for (int i = firstUnusedChannel; i < numHostChannels; ++i)
+            audio.clear (i, startFrame, numFrames);
+    }
+
     bool isMatchingStateType (const juce::ValueTree& state) const
     {
         return state.hasType (ids.SOULPatch)
@@ -575,6 +1010,7 @@ private:
         PatchParameter (soul::patch::Parameter::Ptr p)
             : AudioProcessorParameterWithID (p->ID, p->name),
               param (std::move (p)),
+              activeParam (param.get()),
               unit (param->unit.toString<juce::String>()),
               textValues (parseTextValues (param->getProperty ("text"))),
               range (param->minValue, param->maxValue, param->step),
@@ -585,7 +1021,8 @@ private:
         {
         }
 
-        const soul::patch::Parameter::Ptr param;
+        soul::patch::Parameter::Ptr param;
+        std::atomic<soul::patch::Parameter*> activeParam;
         const juce::String unit;
         const juce::StringArray textValues;
         const juce::NormalisableRange<float> range;
@@ -603,15 +1040,24 @@ private:
         juce::StringArray getAllValueStrings() const override            { return textValues; }
 
         float getDefaultValue() const override                           { return convertTo0to1 (initialValue); }
-        float getValue() const override                                  { return convertTo0to1 (param->getValue()); }
+        float getValue() const override                                  { return convertTo0to1 (activeParam.load()->getValue()); }
 
         void setValue (float newValue) override
         {
             auto fullRange = convertFrom0to1 (newValue);
 
-            if (fullRange != param->getValue())
+            auto p = activeParam.load();
+
+            if (fullRange != p->getValue())
             {
-                param->setValue (fullRange);
+                p->setValue (fullRange);
+
+                // if the parameter was rebound while this was happening, the new one needs the value too
+                auto latest = activeParam.load();
+
+                if (latest != p)
+                    latest->setValue (fullRange);
+
                 sendValueChangedMessageToListeners (newValue);
             }
         }
@@ -650,6 +1096,27 @@ private:
             return AudioProcessor::getDefaultNumParameterSteps();
         }
 
+        /** Points this parameter at an equivalent one in a new player. The old parameter
+            must be kept alive (by its player) until the audio thread has stopped using it.
+        */
+        void rebind (soul::patch::Parameter::Ptr newParam)
+        {
+            auto oldParam = activeParam.exchange (newParam.get());
+
+            // Keeps copying until the old value is stable, in case another thread was setting it
+            // while the pointer changed. Any setValue() call after that will see the new parameter.
+            for (;;)
+            {
+                auto value = oldParam->getValue();
+                newParam->setValue (value);
+
+                if (oldParam->getValue() == value)
+                    break;
+            }
+
+            param = std::move (newParam);
+        }
+
     private:
         float convertTo0to1 (float v) const    { return range.convertTo0to1 (range.snapToLegalValue (v)); }
         float convertFrom0to1 (float v) const  { return range.snapToLegalValue (range.convertFrom0to1 (juce::jlimit (0.0f, 1.0f, v))); }
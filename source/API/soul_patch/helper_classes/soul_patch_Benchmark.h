@@ -0,0 +1,408 @@
+/*
+     _____ _____ _____ __
+    |   __|     |  |  |  |
+    |__   |  |  |  |  |  |__
+    |_____|_____|_____|_____|
+
+    Copyright (c) 2018 - ROLI Ltd.
+*/
+
+#pragma once
+
+#ifndef JUCE_AUDIO_BASICS_H_INCLUDED
+ #error "this header is designed to be included in JUCE projects that contain the juce_audio_basics module"
+#endif
+
+#include "../API/soul_patch.h"
+#include "soul_patch_Utilities.h"
+#include <chrono>
+#include <cmath>
+
+#if JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+namespace soul
+{
+namespace patch
+{
+
+//==============================================================================
+/**
+    Measures how quickly patches build and render, so that a headless runner can catch
+    performance regressions.
+
+    Each patch is built for every combination of sample rate and block size in the
+    Settings, and each player is then rendered offline for a fixed length of time.
+    The stimulus is deterministic: every input channel gets a 440Hz sine wave, and a
+    repeating pattern of MIDI notes is sent, so runs can be compared with each other.
+
+    The results can be written out with toJSON(), and a later run can be checked
+    against a stored copy of that JSON with findRegressions().
+*/
+struct PatchBenchmark
+{
+    struct Settings
+    {
+        std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        std::vector<uint32_t> blockSizes { 32, 128, 512, 2048 };
+        double secondsToRender = 10.0;
+    };
+
+    struct Result
+    {
+        std::string patchName, error;
+        double sampleRate = 0;
+        uint32_t blockSize = 0;
+
+        /** The time taken by PatchInstance::compileNewPlayer(), which includes both
+            compiling and linking the program.
+        */
+        double buildSeconds = 0;
+
+        /** The total time spent in render(), and the ratio of the length of audio rendered
+            to that time. A real-time factor of 100 means the patch renders 100x faster
+            than it plays.
+        */
+        double renderSeconds = 0, realTimeFactor = 0;
+
+        double medianBlockSeconds = 0, p99BlockSeconds = 0, maxBlockSeconds = 0;
+
+        /** The standard deviation of the block render times, as a proportion of their mean. */
+        double blockJitter = 0;
+
+        /** How much the process's resident memory grew between the start of the build and
+            the end of the render, while the player was still alive, or 0 if the platform
+            can't provide it.
+        */
+        int64_t memoryUsedBytes = 0;
+
+        bool succeeded() const          { return error.empty(); }
+    };
+
+    //==============================================================================
+    /** Builds and renders a patch at one sample rate and block size. */
+    static Result run (PatchInstance& patch, double sampleRate, uint32_t blockSize, double secondsToRender)
+    {
+        Result result;
+        result.patchName = patch.getDescription().name.toString<std::string>();
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+
+        PatchPlayerConfiguration config;
+        config.sampleRate = sampleRate;
+        config.maxFramesPerBlock = blockSize;
+
+        juce::String error;
+        auto memoryAtStart = getResidentMemoryBytes();
+        auto buildStart = clock::now();
+        auto player = compilePlayableNewPlayer (patch, config, error);
+        result.buildSeconds = getSecondsSince (buildStart);
+
+        if (player == nullptr)
+        {
+            result.error = error.toStdString();
+            return result;
+        }
+
+        auto numInputChannels  = getTotalNumChannels (player->getInputBuses());
+        auto numOutputChannels = getTotalNumChannels (player->getOutputBuses());
+        auto numBlocks = (size_t) std::ceil (secondsToRender * sampleRate / blockSize);
+
+        juce::AudioBuffer<float> inputs ((int) numInputChannels, (int) blockSize),
+                                 outputs ((int) numOutputChannels, (int) blockSize);
+        std::vector<MIDIMessage> midi;
+        std::vector<double> blockTimes;
+        midi.reserve (16);
+        blockTimes.reserve (numBlocks);
+
+        Stimulus stimulus (sampleRate);
+
+        for (size_t i = 0; i < numBlocks; ++i)
+        {
+            stimulus.fillNextBlock (inputs, midi, blockSize);
+
+            auto rc = createRenderContext (inputs.getArrayOfReadPointers(), numInputChannels,
+                                           outputs.getArrayOfWritePointers(), numOutputChannels,
+                                           midi, blockSize);
+
+            auto blockStart = clock::now();
+
+            if (player->render (rc) != PatchPlayer::RenderResult::ok)
+            {
+                result.error = "Render failed";
+                return result;
+            }
+
+            blockTimes.push_back (getSecondsSince (blockStart));
+        }
+
+        addBlockTimeStatistics (result, blockTimes, numBlocks * blockSize / sampleRate);
+        result.memoryUsedBytes = std::max ((int64_t) 0, getResidentMemoryBytes() - memoryAtStart);
+        return result;
+    }
+
+    /** Runs the patch at every sample rate and block size in the settings. */
+    static std::vector<Result> run (PatchInstance& patch, const Settings& settings)
+    {
+        std::vector<Result> results;
+
+        for (auto rate : settings.sampleRates)
+            for (auto blockSize : settings.blockSizes)
+                results.push_back (run (patch, rate, blockSize, settings.secondsToRender));
+
+        return results;
+    }
+
+    /** Loads each of a list of .soulpatch files, and benchmarks them all. */
+    static std::vector<Result> run (const SOULPatchLibrary& library,
+                                    const juce::Array<juce::File>& manifestFiles,
+                                    const Settings& settings)
+    {
+        std::vector<Result> results;
+
+        for (auto& file : manifestFiles)
+        {
+            if (auto patch = library.createPatchFromFileBundle (file.getFullPathName().toRawUTF8()))
+            {
+                for (auto& r : run (*patch, settings))
+                    results.push_back (std::move (r));
+            }
+            else
+            {
+                Result r;
+                r.patchName = file.getFileName().toStdString();
+                r.error = "Failed to load patch";
+                results.push_back (std::move (r));
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    static juce::var toJSON (const std::vector<Result>& results)
+    {
+        juce::Array<juce::var> list;
+
+        for (auto& r : results)
+        {
+            auto o = new juce::DynamicObject();
+            o->setProperty ("patch",           juce::String (r.patchName));
+            o->setProperty ("sampleRate",      r.sampleRate);
+            o->setProperty ("blockSize",       (int) r.blockSize);
+
+            if (r.succeeded())
+            {
+                o->setProperty ("buildSeconds",       r.buildSeconds);
+                o->setProperty ("renderSeconds",      r.renderSeconds);
+                o->setProperty ("realTimeFactor",     r.realTimeFactor);
+                o->setProperty ("medianBlockSeconds", r.medianBlockSeconds);
+                o->setProperty ("p99BlockSeconds",    r.p99BlockSeconds);
+                o->setProperty ("maxBlockSeconds",    r.maxBlockSeconds);
+                o->setProperty ("blockJitter",        r.blockJitter);
+                o->setProperty ("memoryUsedBytes",    (juce::int64) r.memoryUsedBytes);
+            }
+            else
+            {
+                o->setProperty ("error", juce::String (r.error));
+            }
+
+            list.add (juce::var (o));
+        }
+
+        auto top = new juce::DynamicObject();
+        top->setProperty ("results", list);
+        return juce::var (top);
+    }
+
+    /** Compares a set of results from toJSON() with a baseline in the same format, and
+        returns a description of each run that has got slower by more than the given
+        proportion, has started to fail, or uses more memory by more than that proportion.
+        Memory changes of less than a megabyte are ignored, as the allocator makes them noisy.
+        Runs that only appear in one of the two sets are ignored.
+    */
+    static juce::StringArray findRegressions (const juce::var& results, const juce::var& baseline, double tolerance = 0.1)
+    {
+        juce::StringArray regressions;
+
+        auto checkValue = [&] (const juce::String& runName, const juce::var& current, const juce::var& base,
+                               const char* property, bool higherIsBetter, double minimumChange = 0)
+        {
+            auto newValue = (double) current[property];
+            auto oldValue = (double) base[property];
+
+            if (oldValue <= 0)
+                return;
+
+            if (std::abs (newValue - oldValue) < minimumChange)
+                return;
+
+            auto ratio = newValue / oldValue;
+
+            if (higherIsBetter ? (ratio < 1.0 - tolerance) : (ratio > 1.0 + tolerance))
+                regressions.add (runName + ": " + property + " changed from " + juce::String (oldValue)
+                                   + " to " + juce::String (newValue));
+        };
+
+        if (auto* currentRuns = results["results"].getArray())
+        {
+            for (auto& current : *currentRuns)
+            {
+                auto runName = getRunName (current);
+
+                if (auto base = findRun (baseline, runName); ! base.isVoid())
+                {
+                    if (current.hasProperty ("error") && ! base.hasProperty ("error"))
+                    {
+                        regressions.add (runName + ": now fails with: " + current["error"].toString());
+                        continue;
+                    }
+
+                    checkValue (runName, current, base, "buildSeconds",    false);
+                    checkValue (runName, current, base, "realTimeFactor",  true);
+                    checkValue (runName, current, base, "p99BlockSeconds", false);
+                    checkValue (runName, current, base, "memoryUsedBytes", false, 1024.0 * 1024.0);
+                }
+            }
+        }
+
+        return regressions;
+    }
+
+private:
+    //==============================================================================
+    using clock = std::chrono::steady_clock;
+
+    static double getSecondsSince (clock::time_point start)
+    {
+        return std::chrono::duration<double> (clock::now() - start).count();
+    }
+
+    static void addBlockTimeStatistics (Result& result, std::vector<double>& blockTimes, double secondsRendered)
+    {
+        if (blockTimes.empty())
+            return;
+
+        double total = 0;
+
+        for (auto t : blockTimes)
+            total += t;
+
+        auto mean = total / (double) blockTimes.size();
+        double sumOfSquares = 0;
+
+        for (auto t : blockTimes)
+            sumOfSquares += (t - mean) * (t - mean);
+
+        std::sort (blockTimes.begin(), blockTimes.end());
+
+        auto getPercentile = [&] (double p)  { return blockTimes[(size_t) (p * (double) (blockTimes.size() - 1))]; };
+
+        result.renderSeconds      = total;
+        result.realTimeFactor     = total > 0 ? secondsRendered / total : 0;
+        result.medianBlockSeconds = getPercentile (0.5);
+        result.p99BlockSeconds    = getPercentile (0.99);
+        result.maxBlockSeconds    = blockTimes.back();
+        result.blockJitter        = mean > 0 ? std::sqrt (sumOfSquares / (double) blockTimes.size()) / mean : 0;
+    }
+
+    /** Returns the process's current resident memory, or 0 if the platform can't provide it. */
+    static int64_t getResidentMemoryBytes()
+    {
+       #if JUCE_LINUX
+        auto fields = juce::StringArray::fromTokens (juce::File ("/proc/self/statm").loadFileAsString(), false);
+
+        if (fields.size() > 1)
+            return fields[1].getLargeIntValue() * (int64_t) sysconf (_SC_PAGESIZE);
+
+        return 0;
+       #elif JUCE_MAC || JUCE_IOS
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+            return 0;
+
+        return (int64_t) info.resident_size;
+       #else
+        return 0;
+       #endif
+    }
+
+    static juce::String getRunName (const juce::var& r)
+    {
+        return r["patch"].toString() + " @ " + r["sampleRate"].toString() + "Hz/" + r["blockSize"].toString();
+    }
+
+    static juce::var findRun (const juce::var& resultSet, const juce::String& name)
+    {
+        if (auto* runs = resultSet["results"].getArray())
+            for (auto& r : *runs)
+                if (getRunName (r) == name)
+                    return r;
+
+        return {};
+    }
+
+    //==============================================================================
+    /** Generates the audio and MIDI that's fed to the patch. A chord of four notes is
+        played as an arpeggio, with a new note starting every quarter of a second.
+    */
+    struct Stimulus
+    {
+        Stimulus (double rate)
+            : phaseIncrement (juce::MathConstants<double>::twoPi * 440.0 / rate),
+              framesPerNote ((uint64_t) (rate / 4))
+        {}
+
+        void fillNextBlock (juce::AudioBuffer<float>& audio, std::vector<MIDIMessage>& midi, uint32_t numFrames)
+        {
+            auto startPhase = phase;
+
+            for (int chan = 0; chan < audio.getNumChannels(); ++chan)
+            {
+                phase = startPhase;
+                auto* dest = audio.getWritePointer (chan);
+
+                for (uint32_t i = 0; i < numFrames; ++i)
+                {
+                    dest[i] = 0.5f * (float) std::sin (phase);
+                    phase += phaseIncrement;
+                }
+            }
+
+            if (audio.getNumChannels() == 0)
+                phase += phaseIncrement * numFrames;
+
+            phase = std::fmod (phase, juce::MathConstants<double>::twoPi);
+
+            midi.clear();
+            auto nextNoteFrame = ((position + framesPerNote - 1) / framesPerNote) * framesPerNote;
+
+            for (auto frame = nextNoteFrame; frame < position + numFrames; frame += framesPerNote)
+            {
+                static constexpr uint8_t notes[] = { 48, 52, 55, 60 };
+                auto offset = (uint32_t) (frame - position);
+                auto noteIndex = (frame / framesPerNote) % 4;
+
+                if (frame > 0)
+                    midi.push_back ({ offset, 0x80, notes[(noteIndex + 3) % 4], 0 });
+
+                midi.push_back ({ offset, 0x90, notes[noteIndex], 100 });
+            }
+
+            position += numFrames;
+        }
+
+        double phase = 0;
+        const double phaseIncrement;
+        const uint64_t framesPerNote;
+        uint64_t position = 0;
+    };
+};
+
+} // namespace patch
+} // namespace soul
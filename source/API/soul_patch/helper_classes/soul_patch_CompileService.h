@@ -0,0 +1,307 @@
+/*
+     _____ _____ _____ __
+    |   __|     |  |  |  |
+    |__   |  |  |  |  |  |__
+    |_____|_____|_____|_____|
+
+    Copyright (c) 2018 - ROLI Ltd.
+*/
+
+#pragma once
+
+#ifndef JUCE_CORE_H_INCLUDED
+ #error "this header is designed to be included in JUCE projects that contain the juce_core module"
+#endif
+
+#include "../API/soul_patch.h"
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+namespace soul
+{
+namespace patch
+{
+
+//==============================================================================
+/**
+    A shared pool of worker threads which builds new players for any number of
+    clients, such as SOULPatchAudioProcessor objects.
+
+    Clients get hold of the service with getSharedInstance(), register themselves with
+    addClient(), and call requestCompile() whenever something happens that may mean they
+    need a new build. Pending requests are run highest-priority first, and among equal
+    priorities, the client whose request was made most recently goes first. The number of
+    threads is bounded, so a host which restores a session containing many instances won't
+    have all of them competing for the CPU at once, and the ones that the user is looking
+    at can jump the queue.
+
+    While a client is registered, it's also polled at a low priority about once a second,
+    so that it can check whether its source files have been modified.
+
+    The service is deleted when the last object holding a pointer to it releases it, rather
+    than by a static destructor, which might run while a DLL is being unloaded, when it's
+    not safe to wait for threads to stop. Deleting it cancels any pending jobs, and waits
+    for the worker threads to finish the jobs that they're running and stop, so none of
+    them can still be executing code from a plugin after the host has released it.
+*/
+struct PatchCompileService
+{
+    using Ptr = std::shared_ptr<PatchCompileService>;
+
+    PatchCompileService() = default;
+
+    ~PatchCompileService()
+    {
+        {
+            std::lock_guard<std::mutex> l (queue.lock);
+            jassert (queue.clients.empty()); // all clients must be removed before the service is deleted
+            queue.pendingJobs.clear();
+            queue.shouldExit = true;
+        }
+
+        queue.jobAvailable.notify_all();
+
+        for (auto& t : workers)
+            t.join();
+    }
+
+    /** Returns the service that is shared by all the clients in this process, creating
+        it if there isn't one. Clients should keep hold of the pointer while they're
+        registered, and the service is deleted when the last one releases it.
+    */
+    static Ptr getSharedInstance()
+    {
+        static std::mutex instanceLock;
+        static std::weak_ptr<PatchCompileService> instance;
+
+        std::lock_guard<std::mutex> l (instanceLock);
+        auto service = instance.lock();
+
+        if (service == nullptr)
+        {
+            service = std::make_shared<PatchCompileService>();
+            instance = service;
+        }
+
+        return service;
+    }
+
+    //==============================================================================
+    /** The base class for an object which uses the service. */
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        /** Called on one of the worker threads to do whatever building is required.
+            The service will never make more than one concurrent call to this for the same client.
+        */
+        virtual void performCompileJob() = 0;
+    };
+
+    /** Registers a client. This doesn't request a compile - call requestCompile() for that.
+        The service keeps a reference to the client while it's registered, or while a job is
+        running for it.
+    */
+    void addClient (std::shared_ptr<Client> c)
+    {
+        std::lock_guard<std::mutex> l (queue.lock);
+
+        if (queue.findClient (*c) == nullptr)
+            queue.clients.push_back (std::move (c));
+    }
+
+    /** Deregisters a client and cancels any pending request that it made.
+        This doesn't wait for a job that is already running for the client: that job carries
+        on, and the service releases its reference to the client when it's finished, so the
+        client's performCompileJob() method must cope with whatever it was building no
+        longer being wanted.
+        Note that if the caller then releases the last pointer to the service, deleting the
+        service does wait for any running jobs to finish, so that call will block until then.
+    */
+    void removeClient (Client& c)
+    {
+        std::lock_guard<std::mutex> l (queue.lock);
+        queue.clients.erase (std::remove_if (queue.clients.begin(), queue.clients.end(),
+                                              [&] (const std::shared_ptr<Client>& other) { return other.get() == &c; }),
+                              queue.clients.end());
+        queue.removePendingJob (c);
+    }
+
+    /** Asks for the client's performCompileJob() method to be called as soon as a worker
+        is free. If the client already has a pending request, it is given the new priority
+        and moved to the front of its priority group. Requests from clients which aren't
+        registered are ignored.
+    */
+    void requestCompile (Client& c, int priority = 0)
+    {
+        {
+            std::lock_guard<std::mutex> l (queue.lock);
+
+            if (auto client = queue.findClient (c))
+            {
+                queue.addPendingJob (std::move (client), priority);
+                startWorkersIfNeeded();
+            }
+        }
+
+        queue.jobAvailable.notify_one();
+    }
+
+    /** Sets the maximum number of worker threads that will be used. */
+    void setMaxNumThreads (uint32_t newMax)
+    {
+        std::lock_guard<std::mutex> l (queue.lock);
+        queue.maxNumThreads = std::max (1u, newMax);
+    }
+
+    static uint32_t getDefaultNumThreads()
+    {
+        return (uint32_t) juce::jlimit (1, 8, juce::SystemStats::getNumCpus() - 1);
+    }
+
+private:
+    //==============================================================================
+    struct PendingJob
+    {
+        std::shared_ptr<Client> client;
+        int priority;
+        uint64_t order;
+    };
+
+    static constexpr int pollingPriority = std::numeric_limits<int>::min();
+    static constexpr auto pollingInterval = std::chrono::milliseconds (1000);
+
+    /** The clients and jobs, which are shared between the service and its worker threads. */
+    struct JobQueue
+    {
+        std::mutex lock;
+        std::condition_variable jobAvailable;
+        std::vector<std::shared_ptr<Client>> clients;
+        std::vector<Client*> runningClients;
+        std::vector<PendingJob> pendingJobs;
+        std::chrono::steady_clock::time_point lastPollTime;
+        uint64_t nextJobOrder = 0;
+        uint32_t maxNumThreads = getDefaultNumThreads();
+        bool shouldExit = false;
+
+        std::shared_ptr<Client> findClient (Client& c) const
+        {
+            for (auto& other : clients)
+                if (other.get() == &c)
+                    return other;
+
+            return {};
+        }
+
+        bool isRunning (Client& c) const
+        {
+            return std::find (runningClients.begin(), runningClients.end(), &c) != runningClients.end();
+        }
+
+        void removePendingJob (Client& c)
+        {
+            pendingJobs.erase (std::remove_if (pendingJobs.begin(), pendingJobs.end(),
+                                               [&] (const PendingJob& j) { return j.client.get() == &c; }),
+                               pendingJobs.end());
+        }
+
+        void addPendingJob (std::shared_ptr<Client> c, int priority)
+        {
+            for (auto& j : pendingJobs)
+            {
+                if (j.client == c)
+                {
+                    if (priority == pollingPriority)
+                        return;
+
+                    j.priority = std::max (j.priority, priority);
+                    j.order = ++nextJobOrder;
+                    return;
+                }
+            }
+
+            pendingJobs.push_back ({ std::move (c), priority, ++nextJobOrder });
+        }
+
+        bool takeNextJob (PendingJob& result)
+        {
+            auto best = pendingJobs.end();
+
+            for (auto j = pendingJobs.begin(); j != pendingJobs.end(); ++j)
+                if (! isRunning (*j->client))
+                    if (best == pendingJobs.end() || j->priority > best->priority
+                         || (j->priority == best->priority && j->order > best->order))
+                        best = j;
+
+            if (best == pendingJobs.end())
+                return false;
+
+            result = std::move (*best);
+            pendingJobs.erase (best);
+            return true;
+        }
+
+        void addPollingJobsIfDue()
+        {
+            auto now = std::chrono::steady_clock::now();
+
+            if (now - lastPollTime >= pollingInterval)
+            {
+                lastPollTime = now;
+
+                for (auto& c : clients)
+                    if (! isRunning (*c))
+                        addPendingJob (c, pollingPriority);
+            }
+        }
+
+        void runWorker()
+        {
+            std::unique_lock<std::mutex> l (lock);
+
+            while (! shouldExit)
+            {
+                PendingJob job;
+
+                if (! takeNextJob (job))
+                {
+                    jobAvailable.wait_for (l, pollingInterval);
+                    addPollingJobsIfDue();
+                    continue;
+                }
+
+                runningClients.push_back (job.client.get());
+                l.unlock();
+
+                job.client->performCompileJob();
+
+                l.lock();
+                runningClients.erase (std::find (runningClients.begin(), runningClients.end(), job.client.get()));
+
+                // the client may be deleted here if it was removed while the job was running
+                l.unlock();
+                job.client.reset();
+                l.lock();
+
+                if (! pendingJobs.empty())
+                    jobAvailable.notify_one();
+            }
+        }
+    };
+
+    JobQueue queue;
+    std::vector<std::thread> workers; // guarded by queue.lock
+
+    void startWorkersIfNeeded()
+    {
+        if (workers.size() < queue.maxNumThreads
+             && workers.size() < queue.pendingJobs.size() + queue.runningClients.size())
+            workers.emplace_back ([this] { queue.runWorker(); });
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (PatchCompileService)
+};
+
+} // namespace patch
+} // namespace soul
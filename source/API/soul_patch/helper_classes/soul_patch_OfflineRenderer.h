@@ -0,0 +1,342 @@
+/*
+     _____ _____ _____ __
+    |   __|     |  |  |  |
+    |__   |  |  |  |  |  |__
+    |_____|_____|_____|_____|
+
+    Copyright (c) 2018 - ROLI Ltd.
+*/
+
+#pragma once
+
+#ifndef JUCE_AUDIO_FORMATS_H_INCLUDED
+ #error "this header is designed to be included in JUCE projects that contain the juce_audio_formats module"
+#endif
+
+#include "../API/soul_patch.h"
+#include "soul_patch_Utilities.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+namespace soul
+{
+namespace patch
+{
+
+//==============================================================================
+/**
+    Renders patches to audio files as fast as possible, rather than in real time.
+
+    Each Job describes a patch, an optional input audio file, a MIDI sequence and a
+    timeline of parameter changes. The player is built with a large maximum block size,
+    and each render call covers as many frames as it can: blocks are only split where a
+    parameter changes, or where there are too many MIDI messages for one block.
+
+    The rendered audio is streamed to a WAV file by a background writer thread, so the
+    rendering never waits for the disk unless the writer falls too far behind.
+
+    Several jobs can be rendered in parallel, which is useful when bouncing a large
+    number of presets. Jobs that are rendered in parallel must each have their own
+    PatchInstance.
+*/
+struct PatchOfflineRenderer
+{
+    /** A change to a parameter's value at a particular time. */
+    struct AutomationPoint
+    {
+        double timeInSeconds;
+        juce::String parameterID;
+        float value;
+    };
+
+    struct Job
+    {
+        PatchInstance::Ptr patch;
+
+        /** If this is a valid audio file, it's fed to the patch's inputs, and its sample rate
+            is used for the render. Otherwise the inputs are silent and sampleRate is used.
+        */
+        juce::File inputFile;
+
+        /** MIDI to send to the patch, with timestamps in seconds. Only messages of up to
+            three bytes are sent.
+        */
+        juce::MidiMessageSequence midi;
+
+        /** Parameter changes, which must be sorted by time. */
+        std::vector<AutomationPoint> automation;
+
+        juce::File outputFile;
+        double sampleRate = 44100.0;
+        int bitsPerSample = 24;
+
+        /** The length of audio to render. If this is zero, the length of the input file is
+            used, or the time of the last MIDI or automation event, with tailSeconds added.
+        */
+        double lengthInSeconds = 0;
+        double tailSeconds = 2.0;
+
+        /** This is limited to half the size of the output writer's buffer. */
+        uint32_t maxBlockSize = 8192;
+    };
+
+    struct Result
+    {
+        juce::File outputFile;
+        juce::String error;
+        uint64_t framesRendered = 0;
+        double renderSeconds = 0;
+
+        bool succeeded() const      { return error.isEmpty(); }
+    };
+
+    //==============================================================================
+    /** Renders a single job, using the given thread to write the output file. */
+    static Result render (const Job& job, juce::TimeSliceThread& writerThread)
+    {
+        Result result;
+        result.outputFile = job.outputFile;
+        auto startTime = std::chrono::steady_clock::now();
+
+        if (job.patch == nullptr)
+            return failed (result, "No patch supplied");
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader;
+
+        if (job.inputFile.existsAsFile())
+        {
+            reader.reset (formats.createReaderFor (job.inputFile));
+
+            if (reader == nullptr)
+                return failed (result, "Couldn't read " + job.inputFile.getFullPathName());
+        }
+
+        auto sampleRate = reader != nullptr ? reader->sampleRate : job.sampleRate;
+
+        // The writer can only accept a block once it has that much free space in its buffer,
+        // so a block bigger than the buffer would never get written
+        auto maxBlockSize = juce::jlimit (1u, writerBufferSize / 2, job.maxBlockSize);
+
+        PatchPlayerConfiguration config;
+        config.sampleRate = sampleRate;
+        config.maxFramesPerBlock = maxBlockSize;
+
+        juce::String error;
+        auto player = compilePlayableNewPlayer (*job.patch, config, error);
+
+        if (player == nullptr)
+            return failed (result, error);
+
+        auto numInputChannels  = getTotalNumChannels (player->getInputBuses());
+        auto numOutputChannels = getTotalNumChannels (player->getOutputBuses());
+
+        auto writer = createWriter (job, sampleRate, numOutputChannels, writerThread);
+
+        if (writer == nullptr)
+            return failed (result, "Couldn't write to " + job.outputFile.getFullPathName());
+
+        auto parameters = findAutomatedParameters (*player, job.automation);
+        auto totalFrames = (uint64_t) (getLengthInSeconds (job, reader.get()) * sampleRate);
+
+        juce::AudioBuffer<float> inputs ((int) numInputChannels, (int) maxBlockSize),
+                                 outputs ((int) numOutputChannels, (int) maxBlockSize);
+        inputs.clear();
+
+        std::vector<MIDIMessage> midi;
+        midi.reserve (maxMIDIMessagesPerBlock);
+        int nextMIDIEvent = 0;
+        size_t nextAutomationPoint = 0;
+        uint64_t position = 0;
+
+        auto toFrame = [=] (double seconds)  { return (uint64_t) std::max (0.0, seconds * sampleRate); };
+
+        while (position < totalFrames)
+        {
+            while (nextAutomationPoint < job.automation.size()
+                    && toFrame (job.automation[nextAutomationPoint].timeInSeconds) <= position)
+            {
+                if (auto param = parameters[nextAutomationPoint])
+                    param->setValue (job.automation[nextAutomationPoint].value);
+
+                ++nextAutomationPoint;
+            }
+
+            auto blockEnd = std::min (totalFrames, position + maxBlockSize);
+
+            if (nextAutomationPoint < job.automation.size())
+                blockEnd = std::min (blockEnd, toFrame (job.automation[nextAutomationPoint].timeInSeconds));
+
+            midi.clear();
+
+            for (; nextMIDIEvent < job.midi.getNumEvents(); ++nextMIDIEvent)
+            {
+                auto& message = job.midi.getEventPointer (nextMIDIEvent)->message;
+                auto frame = std::max (position, toFrame (message.getTimeStamp()));
+
+                if (frame >= blockEnd)
+                    break;
+
+                // The player's MIDI queue has a fixed size, so a dense burst ends the block early.
+                // If all the events so far are on the block's first frame, the block is cut to
+                // a single frame, and the rest of the burst is sent at the start of the next one.
+                if (midi.size() == maxMIDIMessagesPerBlock)
+                {
+                    blockEnd = std::max (frame, position + 1);
+                    break;
+                }
+
+                if (message.getRawDataSize() <= 3)
+                {
+                    auto data = message.getRawData();
+                    auto size = message.getRawDataSize();
+
+                    midi.push_back ({ (uint32_t) (frame - position),
+                                      data[0],
+                                      size > 1 ? data[1] : (uint8_t) 0,
+                                      size > 2 ? data[2] : (uint8_t) 0 });
+                }
+            }
+
+            auto numFrames = (int) (blockEnd - position);
+
+            if (reader != nullptr && numInputChannels > 0)
+                reader->read (&inputs, 0, numFrames, (juce::int64) position, true, true);
+
+            auto rc = createRenderContext (inputs.getArrayOfReadPointers(), numInputChannels,
+                                           outputs.getArrayOfWritePointers(), numOutputChannels,
+                                           midi, (uint32_t) numFrames);
+
+            if (player->render (rc) != PatchPlayer::RenderResult::ok)
+            {
+                writer.reset();
+                job.outputFile.deleteFile();
+                return failed (result, "Render failed");
+            }
+
+            // If the writer's buffer is full, wait for the background thread to catch up
+            while (! writer->write (outputs.getArrayOfReadPointers(), numFrames))
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+            position = blockEnd;
+        }
+
+        writer.reset();
+        result.framesRendered = totalFrames;
+        result.renderSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+    /** Renders a list of jobs, running up to the given number of them in parallel. */
+    static std::vector<Result> render (const std::vector<Job>& jobs, uint32_t numThreads)
+    {
+        std::vector<Result> results (jobs.size());
+        juce::TimeSliceThread writerThread ("SOUL offline render writer");
+        writerThread.startThread();
+
+        std::atomic<size_t> nextJob { 0 };
+        std::vector<std::thread> threads;
+
+        for (uint32_t i = 0; i < std::max (1u, numThreads); ++i)
+        {
+            threads.emplace_back ([&]
+            {
+                for (;;)
+                {
+                    auto index = nextJob++;
+
+                    if (index >= jobs.size())
+                        break;
+
+                    results[index] = render (jobs[index], writerThread);
+                }
+            });
+        }
+
+        for (auto& t : threads)
+            t.join();
+
+        writerThread.stopThread (-1);
+        return results;
+    }
+
+private:
+    //==============================================================================
+    /** This leaves plenty of room in the player's queue of incoming MIDI. */
+    static constexpr size_t maxMIDIMessagesPerBlock = 512;
+
+    /** The number of frames that the background writer can hold before it has to wait for the disk. */
+    static constexpr uint32_t writerBufferSize = 65536;
+
+    static Result failed (Result& r, const juce::String& error)
+    {
+        r.error = error;
+        return r;
+    }
+
+    static double getLengthInSeconds (const Job& job, juce::AudioFormatReader* reader)
+    {
+        if (job.lengthInSeconds > 0)
+            return job.lengthInSeconds;
+
+        if (reader != nullptr)
+            return (double) reader->lengthInSamples / reader->sampleRate + job.tailSeconds;
+
+        auto lastEventTime = job.midi.getEndTime();
+
+        if (! job.automation.empty())
+            lastEventTime = std::max (lastEventTime, job.automation.back().timeInSeconds);
+
+        return lastEventTime + job.tailSeconds;
+    }
+
+    /** Returns the parameter that each automation point refers to, or a nullptr if the
+        patch doesn't have one with that ID.
+    */
+    static std::vector<Parameter::Ptr> findAutomatedParameters (PatchPlayer& player, const std::vector<AutomationPoint>& automation)
+    {
+        std::vector<Parameter::Ptr> result;
+        result.reserve (automation.size());
+        auto parameters = player.getParameters();
+
+        for (auto& point : automation)
+        {
+            Parameter::Ptr match;
+
+            for (auto& p : parameters)
+                if (p->ID.toString<juce::String>() == point.parameterID)
+                    match = p;
+
+            result.push_back (match);
+        }
+
+        return result;
+    }
+
+    static std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> createWriter (const Job& job, double sampleRate,
+                                                                                 uint32_t numChannels,
+                                                                                 juce::TimeSliceThread& writerThread)
+    {
+        job.outputFile.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream (new juce::FileOutputStream (job.outputFile));
+
+        if (! stream->openedOk())
+            return {};
+
+        if (auto* writer = juce::WavAudioFormat().createWriterFor (stream.get(), sampleRate, numChannels,
+                                                                   job.bitsPerSample, {}, 0))
+        {
+            stream.release();
+            return std::make_unique<juce::AudioFormatWriter::ThreadedWriter> (writer, writerThread, (int) writerBufferSize);
+        }
+
+        stream.reset();
+        job.outputFile.deleteFile();
+        return {};
+    }
+};
+
+} // namespace patch
+} // namespace soul
@@ -240,6 +240,63 @@ inline std::vector<VirtualFile::Ptr> findViewFiles (VirtualFile& manifestFile)
     return views;
 }
 
+//==============================================================================
+/** Returns the total number of channels in a list of buses. */
+inline uint32_t getTotalNumChannels (Span<Bus> buses)
+{
+    uint32_t total = 0;
+
+    for (auto& b : buses)
+        total += b.numChannels;
+
+    return total;
+}
+
+/** Builds a new player for a patch, for use by code that renders it without a host.
+    If the player can't be played, this returns nullptr, and sets the error string to
+    the first error that the compiler reported.
+*/
+inline PatchPlayer::Ptr compilePlayableNewPlayer (PatchInstance& patch, const PatchPlayerConfiguration& config,
+                                                  juce::String& error)
+{
+    auto player = patch.compileNewPlayer (config, nullptr, nullptr, nullptr);
+
+    if (player != nullptr && player->isPlayable())
+        return player;
+
+    error = "Failed to build the patch";
+
+    if (player != nullptr)
+    {
+        for (auto& m : player->getCompileMessages())
+        {
+            if (m.isError)
+            {
+                error = m.fullMessage.toString<juce::String>();
+                break;
+            }
+        }
+    }
+
+    return {};
+}
+
+/** Creates a RenderContext for a block, using all the channels of a player's buses. */
+inline PatchPlayer::RenderContext createRenderContext (const float* const* inputChannels, uint32_t numInputChannels,
+                                                       float* const* outputChannels, uint32_t numOutputChannels,
+                                                       const std::vector<MIDIMessage>& midi, uint32_t numFrames)
+{
+    PatchPlayer::RenderContext rc;
+    rc.inputChannels     = inputChannels;
+    rc.outputChannels    = outputChannels;
+    rc.incomingMIDI      = midi.data();
+    rc.numFrames         = numFrames;
+    rc.numInputChannels  = numInputChannels;
+    rc.numOutputChannels = numOutputChannels;
+    rc.numMIDIMessages   = (uint32_t) midi.size();
+    return rc;
+}
+
 
 } // namespace patch
 } // namespace soul
@@ -373,7 +373,7 @@ struct AST
 
         virtual void performLocalNameSearch (NameSearch& search, const Statement* statementToSearchUpTo) const = 0;
 
-        ModuleBasePtr findSubModuleNamed (Identifier name) const
+        virtual ModuleBasePtr findSubModuleNamed (Identifier name) const
         {
             for (auto& m : getSubModules())
                 if (m->name == name)
@@ -519,6 +519,16 @@ struct AST
         {
             auto targetName = search.partiallyQualifiedPath.getLastPart();
 
+            if (auto index = getNameIndex())
+            {
+                auto found = index->names.find (targetName);
+
+                if (found != index->names.end())
+                    found->second.addMatches (search);
+
+                return;
+            }
+
             if (search.findVariables)
                 search.addFirstWithName (getVariables(), targetName);
 
@@ -529,17 +539,9 @@ struct AST
             }
 
             if (search.findFunctions)
-            {
                 for (auto& f : getFunctions())
-                {
-                    if (f->name == targetName
-                         && (search.requiredNumFunctionArgs < 0
-                              || f->parameters.size() == static_cast<uint32_t> (search.requiredNumFunctionArgs)))
-                    {
-                        search.addResult (*f);
-                    }
-                }
-            }
+                    if (f->name == targetName)
+                        addFunctionIfArgsMatch (search, *f);
 
             if (search.findEndpoints)
             {
@@ -554,9 +556,175 @@ struct AST
             }
         }
 
+        ModuleBasePtr findSubModuleNamed (Identifier targetName) const override
+        {
+            if (auto index = getNameIndex())
+            {
+                auto found = index->names.find (targetName);
+                return found != index->names.end() ? found->second.subModule : ModuleBasePtr();
+            }
+
+            return Scope::findSubModuleNamed (targetName);
+        }
+
+        /** Discards the cached name lookup table.
+            The table notices when declarations are added or removed, but if you rename an
+            item that's already in one of this module's lists, you need to call this.
+        */
+        void invalidateNameIndex()          { nameIndex.reset(); }
+
         //==============================================================================
         Identifier name;
         bool isFullyResolved = false;
+
+    private:
+        //==============================================================================
+        /** A hash table of the names declared in a module, which lets a search avoid scanning
+            every list of declarations. It's only worth building for modules that have more
+            than a handful of items.
+        */
+        struct NameIndex
+        {
+            struct Entry
+            {
+                ASTObjectPtr variable, structDeclaration, usingDeclaration, input, output, processorAlias;
+                ModuleBasePtr subModule;
+                ArrayWithPreallocation<FunctionPtr, 2> functions;
+
+                void addMatches (NameSearch& search) const
+                {
+                    if (search.findVariables && variable != nullptr)
+                        search.addResult (*variable);
+
+                    if (search.findTypes)
+                    {
+                        if (structDeclaration != nullptr)   search.addResult (*structDeclaration);
+                        if (usingDeclaration != nullptr)    search.addResult (*usingDeclaration);
+                    }
+
+                    if (search.findFunctions)
+                        for (auto& f : functions)
+                            addFunctionIfArgsMatch (search, *f);
+
+                    if (search.findEndpoints)
+                    {
+                        if (input != nullptr)   search.addResult (*input);
+                        if (output != nullptr)  search.addResult (*output);
+                    }
+
+                    if (search.findProcessorsAndNamespaces)
+                    {
+                        if (subModule != nullptr)        search.addResult (*subModule);
+                        if (processorAlias != nullptr)   search.addResult (*processorAlias);
+                    }
+                }
+            };
+
+            /** Enough information about a declaration list to tell whether it has been
+                modified since the index was built, without looking at its contents.
+            */
+            struct ListState
+            {
+                const void* start = nullptr;
+                const void* last = nullptr;
+                size_t size = 0;
+
+                template <typename ArrayType>
+                static ListState of (const ArrayType& a)
+                {
+                    return { a.data(), a.empty() ? nullptr : a.back().get(), a.size() };
+                }
+
+                bool operator== (const ListState& other) const
+                {
+                    return start == other.start && last == other.last && size == other.size;
+                }
+            };
+
+            using ListStates = std::array<ListState, 8>;
+
+            ListStates listStates;
+            std::unordered_map<Identifier, Entry> names;
+        };
+
+        static constexpr size_t minItemsToIndex = 16;
+        mutable std::unique_ptr<NameIndex> nameIndex;
+
+        static void addFunctionIfArgsMatch (NameSearch& search, Function& f)
+        {
+            if (search.requiredNumFunctionArgs < 0
+                 || f.parameters.size() == static_cast<uint32_t> (search.requiredNumFunctionArgs))
+                search.addResult (f);
+        }
+
+        NameIndex::ListStates getListStates() const
+        {
+            return { NameIndex::ListState::of (getVariables()),
+                     NameIndex::ListState::of (getFunctions()),
+                     NameIndex::ListState::of (getStructDeclarations()),
+                     NameIndex::ListState::of (getUsingDeclarations()),
+                     NameIndex::ListState::of (getSubModules()),
+                     NameIndex::ListState::of (getProcessorAliases()),
+                     NameIndex::ListState::of (getInputs()),
+                     NameIndex::ListState::of (getOutputs()) };
+        }
+
+        /** Returns the up-to-date index for this module, or nullptr if it's too small to need one. */
+        const NameIndex* getNameIndex() const
+        {
+            auto states = getListStates();
+
+            if (nameIndex != nullptr && nameIndex->listStates == states)
+                return nameIndex.get();
+
+            size_t numItems = 0;
+
+            for (auto& state : states)
+                numItems += state.size;
+
+            if (numItems < minItemsToIndex)
+            {
+                nameIndex.reset();
+                return nullptr;
+            }
+
+            auto index = std::make_unique<NameIndex>();
+            index->listStates = states;
+            index->names.reserve (numItems);
+
+            // Only the first declaration of each kind is recorded, to match the order in which a linear search would find them
+            auto addFirst = [&] (auto list, ASTObjectPtr NameIndex::Entry::* slot)
+            {
+                for (auto& item : list)
+                {
+                    auto& target = index->names[item->name].*slot;
+
+                    if (target == nullptr)
+                        target = item;
+                }
+            };
+
+            addFirst (getVariables(),           &NameIndex::Entry::variable);
+            addFirst (getStructDeclarations(),  &NameIndex::Entry::structDeclaration);
+            addFirst (getUsingDeclarations(),   &NameIndex::Entry::usingDeclaration);
+            addFirst (getInputs(),              &NameIndex::Entry::input);
+            addFirst (getOutputs(),             &NameIndex::Entry::output);
+            addFirst (getProcessorAliases(),    &NameIndex::Entry::processorAlias);
+
+            for (auto& m : getSubModules())
+            {
+                auto& target = index->names[m->name].subModule;
+
+                if (target == nullptr)
+                    target = m;
+            }
+
+            for (auto& f : getFunctions())
+                index->names[f->name].functions.push_back (f);
+
+            nameIndex = std::move (index);
+            return nameIndex.get();
+        }
     };
 
     //==============================================================================
@@ -0,0 +1,86 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#if ! SOUL_INSIDE_CORE_CPP
+ #error "Don't add this cpp file to your build, it gets included indirectly by soul_core.cpp"
+#endif
+
+namespace soul
+{
+
+BatchCompiler::BatchCompiler (uint32_t numThreads)  : pool (numThreads) {}
+BatchCompiler::~BatchCompiler() = default;
+
+/** Makes a new SourceCodeText for a location, so that a worker thread never touches the
+    reference count of the caller's copy.
+*/
+static CodeLocation createPrivateCopy (const CodeLocation& original)
+{
+    auto& source = *original.sourceCode;
+
+    auto copy = source.isInternal ? SourceCodeText::createInternal (source.filename, source.content)
+                                  : SourceCodeText::createForFile (source.filename, source.content);
+
+    CodeLocation location (copy);
+    location.location = UTF8Reader (copy->content.c_str() + (original.location.getAddress() - source.content.c_str()));
+    return location;
+}
+
+std::vector<BatchCompiler::Result> BatchCompiler::compile (const std::vector<Job>& jobs)
+{
+    std::vector<Result> results (jobs.size());
+
+    pool.parallelFor (jobs.size(), [&] (size_t index)
+    {
+        auto& job = jobs[index];
+        auto& result = results[index];
+
+        Compiler compiler;
+        bool ok = true;
+
+        for (auto& code : job.code)
+        {
+            if (! compiler.addCode (result.messages, createPrivateCopy (code)))
+            {
+                ok = false;
+                break;
+            }
+        }
+
+        if (ok)
+            result.program = compiler.link (result.messages, job.linkOptions);
+    });
+
+    return results;
+}
+
+std::vector<BatchCompiler::Result> BatchCompiler::compile (const std::vector<std::vector<CodeLocation>>& sources,
+                                                           const LinkOptions& linkOptions)
+{
+    std::vector<Job> jobs;
+    jobs.reserve (sources.size());
+
+    for (auto& code : sources)
+        jobs.push_back ({ code, linkOptions });
+
+    return compile (jobs);
+}
+
+} // namespace soul
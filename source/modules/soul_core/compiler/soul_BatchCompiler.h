@@ -0,0 +1,71 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+namespace soul
+{
+
+//==============================================================================
+/**
+    Compiles a set of independent programs in parallel, using a pool of threads.
+
+    Each job is built by its own Compiler on one of the pool's threads. The results come
+    back in the same order as the jobs.
+
+    The source code for each job is copied before it is handed to a worker, so the
+    same CodeLocation can safely appear in several jobs. (CodeLocation and Program use
+    non-atomic reference counts, so neither may be shared between threads.)
+*/
+class BatchCompiler  final
+{
+public:
+    /** Creates a compiler with the given number of threads, or one thread per hardware
+        thread if the number is 0.
+    */
+    BatchCompiler (uint32_t numThreads = 0);
+    ~BatchCompiler();
+
+    /** The source files and link options for one program. */
+    struct Job
+    {
+        std::vector<CodeLocation> code;
+        LinkOptions linkOptions;
+    };
+
+    /** The program produced by a job, which will be empty if it failed to build, and
+        the messages that were emitted while building it.
+    */
+    struct Result
+    {
+        Program program;
+        CompileMessageList messages;
+    };
+
+    /** Builds all the jobs and waits for them to finish. */
+    std::vector<Result> compile (const std::vector<Job>& jobs);
+
+    /** Builds a set of programs which all use the same link options. */
+    std::vector<Result> compile (const std::vector<std::vector<CodeLocation>>& sources,
+                                 const LinkOptions& linkOptions);
+
+private:
+    ThreadPool pool;
+};
+
+} // namespace soul
@@ -50,6 +50,7 @@ bool Compiler::addCode (CompileMessageList& messageList, CodeLocation code)
             code.throwError (Errors::emptyProgram());
 
         SOUL_LOG_TIME_OF_SCOPE ("initial resolution pass: " + code.getFilename());
+        SOUL_PROFILE_PHASE ("add code");
         soul::CompileMessageHandler handler (messageList);
         compile (std::move (code));
         return true;
@@ -65,6 +66,7 @@ void Compiler::addDefaultBuiltInLibrary()
 
     try
     {
+        SOUL_PROFILE_PHASE ("built-in library");
         soul::CompileMessageHandler handler (list);
         compile (getDefaultLibraryCode());
 
@@ -100,6 +102,44 @@ std::vector<AST::ModuleBasePtr> Compiler::parseTopLevelDeclarations (AST::Alloca
     return StructuralParser::parseTopLevelDeclarations (allocator, code, parentNamespace);
 }
 
+size_t Compiler::countTokens (CompileMessageList& messageList, CodeLocation code)
+{
+    struct TokenCounter  : public Tokeniser<Keyword::Matcher,
+                                            StandardOperatorMatcher,
+                                            StandardIdentifierMatcher>
+    {
+        TokenCounter (const CodeLocation& c) : Tokeniser (c) {}
+
+        [[noreturn]] void throwError (const CompileMessage& message) const override
+        {
+            soul::throwError (message.withLocation (location));
+        }
+    };
+
+    try
+    {
+        soul::CompileMessageHandler handler (messageList);
+        TokenCounter tokeniser (code);
+        size_t numTokens = 0;
+
+        while (! tokeniser.matches (Token::eof))
+        {
+            tokeniser.skip();
+            ++numTokens;
+        }
+
+        return numTokens;
+    }
+    catch (soul::AbortCompilationException) {}
+
+    return 0;
+}
+
+CodeLocation Compiler::getBuiltInLibraryCode()
+{
+    return getDefaultLibraryCode();
+}
+
 static void mergeNamespaces (AST::Namespace& target, AST::Namespace& source)
 {
     auto newParentScope = std::addressof (target);
@@ -176,11 +216,26 @@ void Compiler::compile (CodeLocation code)
 {
     SOUL_LOG_TIME_OF_SCOPE ("compile: " + code.getFilename());
 
-    for (auto& m : StructuralParser::parseTopLevelDeclarations (allocator, code, *topLevelNamespace))
-        SanityCheckPass::runPreResolution (*m);
+    std::vector<AST::ModuleBasePtr> modules;
+
+    {
+        SOUL_PROFILE_PHASE ("parse");
+        modules = StructuralParser::parseTopLevelDeclarations (allocator, code, *topLevelNamespace);
+    }
+
+    {
+        SOUL_PROFILE_PHASE ("pre-resolution sanity check");
+
+        for (auto& m : modules)
+            SanityCheckPass::runPreResolution (*m);
+    }
 
-    ResolutionPass::run (allocator, *topLevelNamespace, true);
+    {
+        SOUL_PROFILE_PHASE ("resolution");
+        ResolutionPass::run (allocator, *topLevelNamespace, true);
+    }
 
+    SOUL_PROFILE_PHASE ("duplicate name check");
     mergeDuplicateNamespaces (*topLevelNamespace);
     SanityCheckPass::runDuplicateNameChecker (*topLevelNamespace);
 }
@@ -273,6 +328,128 @@ Program Compiler::link (CompileMessageList& messageList, const LinkOptions& link
     return {};
 }
 
+//==============================================================================
+/** Redirects calls to some of the float32 intrinsics to the approximations in
+    soul::intrinsics::fast, in any processor or function that has a "fastMath"
+    annotation, or everywhere if the link options ask for it.
+    The calls are turned back into unresolved CallOrCasts, so that the resolution pass
+    which follows will find and specialise the fast versions.
+*/
+struct FastMathSubstitution  : public RewritingASTVisitor
+{
+    FastMathSubstitution (AST::Allocator& a, bool enableForWholeProgram)
+        : allocator (a), enabledByDefault (enableForWholeProgram) {}
+
+    using RewritingASTVisitor::visit;
+
+    AST::NamespacePtr visit (AST::Namespace& n) override
+    {
+        // The library functions are left as they are
+        if (n.getFullyQualifiedPath().toString() == getIntrinsicsNamespaceName())
+            return n;
+
+        auto wasEnabled = isEnabled;
+        isEnabled = enabledByDefault;
+        RewritingASTVisitor::visit (n);
+        isEnabled = wasEnabled;
+        return n;
+    }
+
+    AST::ProcessorPtr visit (AST::Processor& p) override
+    {
+        // A namespace visits its sub-modules before its functions, so this must be restored
+        auto wasEnabled = isEnabled;
+        isEnabled = enabledByDefault || isRequestedBy (p.annotation);
+        RewritingASTVisitor::visit (p);
+        isEnabled = wasEnabled;
+        return p;
+    }
+
+    AST::FunctionPtr visit (AST::Function& f) override
+    {
+        if (f.isGeneric())
+            return f;
+
+        auto wasEnabled = isEnabled;
+        isEnabled = isEnabled || isRequestedBy (f.annotation);
+        RewritingASTVisitor::visit (f);
+        isEnabled = wasEnabled;
+        return f;
+    }
+
+    AST::ExpPtr visit (AST::FunctionCall& call) override
+    {
+        RewritingASTVisitor::visit (call);
+
+        if (isEnabled && hasFastVersion (call.targetFunction.intrinsic) && areAllArgumentsFloat32 (call))
+        {
+            auto path = IdentifierPath::fromString (allocator.identifiers, std::string (getIntrinsicsNamespaceName())
+                                                                              + "::fast::" + getIntrinsicName (call.targetFunction.intrinsic));
+
+            return allocator.allocate<AST::CallOrCast> (allocator.allocate<AST::QualifiedIdentifier> (call.context, path),
+                                                        call.arguments, call.isMethodCall);
+        }
+
+        return call;
+    }
+
+private:
+    AST::Allocator& allocator;
+    const bool enabledByDefault;
+    bool isEnabled = false;
+
+    static bool isRequestedBy (const AST::Annotation& annotation)
+    {
+        if (auto property = annotation.findProperty ("fastMath"))
+            if (auto c = property->value->getAsConstant())
+                return c->value.getAsBool();
+
+        return false;
+    }
+
+    static bool hasFastVersion (IntrinsicType i)
+    {
+        return i == IntrinsicType::sin || i == IntrinsicType::cos || i == IntrinsicType::tan
+            || i == IntrinsicType::exp || i == IntrinsicType::tanh;
+    }
+
+    static bool areAllArgumentsFloat32 (const AST::FunctionCall& call)
+    {
+        for (auto& type : call.getArgumentTypes())
+            if (! (type.isPrimitiveOrVector() && type.isFloat32()))
+                return false;
+
+        return true;
+    }
+};
+
+static bool anyProcessorsRequestFastMath (const AST::Namespace& ns)
+{
+    for (auto& m : ns.subModules)
+    {
+        if (auto subNamespace = cast<AST::Namespace> (m))
+        {
+            if (anyProcessorsRequestFastMath (*subNamespace))
+                return true;
+        }
+        else if (auto p = cast<AST::Processor> (m))
+        {
+            if (p->annotation.findProperty ("fastMath") != nullptr)
+                return true;
+
+            for (auto& f : p->functions)
+                if (f->annotation.findProperty ("fastMath") != nullptr)
+                    return true;
+        }
+    }
+
+    for (auto& f : ns.functions)
+        if (f->annotation.findProperty ("fastMath") != nullptr)
+            return true;
+
+    return false;
+}
+
 static void testHEARTRoundTrip (const Program& program)
 {
     ignoreUnused (program);
@@ -290,19 +467,48 @@ Program Compiler::link (CompileMessageList& messageList, const LinkOptions& link
     try
     {
         SOUL_LOG_TIME_OF_SCOPE ("link time");
-        ignoreUnused (linkOptions);
+        SOUL_PROFILE_PHASE ("link");
         CompileMessageHandler handler (messageList);
-        resolveProcessorInstances (processorToRun);
-        mergeDuplicateNamespaces (*topLevelNamespace);
-        removeModulesWithSpecialisationParams (topLevelNamespace);
-        ResolutionPass::run (allocator, *topLevelNamespace, true);
-        ResolutionPass::run (allocator, *topLevelNamespace, false);
-        createImplicitProcessorInstances (topLevelNamespace);
+
+        {
+            SOUL_PROFILE_PHASE ("resolve processor instances");
+            resolveProcessorInstances (processorToRun);
+            mergeDuplicateNamespaces (*topLevelNamespace);
+            removeModulesWithSpecialisationParams (topLevelNamespace);
+        }
+
+        {
+            SOUL_PROFILE_PHASE ("fast math substitution");
+
+            // The fast versions are only compiled when something will use them, so that
+            // other programs' HEART isn't cluttered with an extra namespace
+            if (linkOptions.getFastMath() || anyProcessorsRequestFastMath (*topLevelNamespace))
+            {
+                compile (getFastMathLibraryCode());
+                FastMathSubstitution (allocator, linkOptions.getFastMath()).visitObject (*topLevelNamespace);
+            }
+        }
+
+        {
+            SOUL_PROFILE_PHASE ("resolution");
+            ResolutionPass::run (allocator, *topLevelNamespace, true);
+            ResolutionPass::run (allocator, *topLevelNamespace, false);
+            createImplicitProcessorInstances (topLevelNamespace);
+        }
 
         Program program;
         program.getStringDictionary() = allocator.stringDictionary;  // Bring the existing string dictionary along so that the handles match
-        compileAllModules (*topLevelNamespace, program, processorToRun);
-        sanityCheck (program);
+
+        {
+            SOUL_PROFILE_PHASE ("HEART generation");
+            compileAllModules (*topLevelNamespace, program, processorToRun);
+        }
+
+        {
+            SOUL_PROFILE_PHASE ("sanity check");
+            sanityCheck (program);
+        }
+
         reset();
 
         SOUL_LOG (program.getMainProcessorOrThrowError().getNameWithoutRootNamespace() + ": linked HEART",
@@ -607,7 +813,14 @@ void Compiler::sanityCheck (Program& program)
 
 void Compiler::optimise (Program& program)
 {
-    Optimisations::optimiseFunctionBlocks (program);
+    SOUL_PROFILE_PHASE ("optimise");
+
+    {
+        SOUL_PROFILE_PHASE ("optimise function blocks");
+        Optimisations::optimiseFunctionBlocks (program);
+    }
+
+    SOUL_PROFILE_PHASE ("remove unused variables");
     Optimisations::removeUnusedVariables (program);
 }
 
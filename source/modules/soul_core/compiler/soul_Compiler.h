@@ -29,6 +29,11 @@ namespace soul
     You can either create a Compiler, feed it some individual chunks of code with
     addCode() and then call link() to create a finished Program. Or you can just call
     Compiler::build() to do this in one step for a single piece of code.
+
+    A Compiler has no shared state, so separate Compilers can be used at the same time
+    on different threads. The objects passed to and from it must be kept to one thread,
+    though: CodeLocation and Program use non-atomic reference counts. To compile a
+    set of programs in parallel, use a BatchCompiler.
 */
 class Compiler  final
 {
@@ -60,6 +65,15 @@ public:
                                                                       CodeLocation code,
                                                                       AST::Namespace& parentNamespace);
 
+    /** Splits a chunk of code into tokens without parsing it, and returns how many it found.
+        If the code contains something that can't be tokenised, the error is added to the
+        message list and 0 is returned. This is mainly useful for measuring the tokeniser's speed.
+    */
+    static size_t countTokens (CompileMessageList& messageList, CodeLocation code);
+
+    /** Returns the built-in library code which is added to every program. */
+    static CodeLocation getBuiltInLibraryCode();
+
 private:
     //==============================================================================
     AST::Allocator allocator;
@@ -47,6 +47,24 @@ struct LinkOptions  : public Annotation
         return (uint64_t) getInt64 (getMaxStateSizeKey(), defaultMaximumStateSize);
     }
 
+    //==============================================================================
+    /** If this is more than 0, a player may stop running the program once its audio input
+        and output have been silent, with no incoming events, for this many blocks.
+        A main processor can also request this with a "suspendWhenSilent" annotation.
+    */
+    static const char* getSuspendWhenSilentKey()    { return "suspend_when_silent"; }
+    void setSuspendWhenSilent (int numBlocks)       { set (getSuspendWhenSilentKey(), Value::createInt32 (numBlocks)); }
+    uint32_t getSuspendWhenSilent() const           { return (uint32_t) std::max ((int64_t) 0, getInt64 (getSuspendWhenSilentKey(), 0)); }
+
+    //==============================================================================
+    /** If this is set, calls to sin, cos, tan, exp and tanh with float32 arguments are
+        replaced throughout the program by the faster approximations in soul::intrinsics::fast.
+        Individual processors and functions can also ask for this with a "fastMath" annotation.
+    */
+    static const char* getFastMathKey()             { return "fast_math"; }
+    void setFastMath (bool shouldUseFastMath)       { set (getFastMathKey(), Value (shouldUseFastMath)); }
+    bool getFastMath() const                        { return getBool (getFastMathKey()); }
+
     //==============================================================================
     static const char* getMainProcessorKey()        { return "main_processor"; }
     void setMainProcessor (const std::string& name) { setPropertyAsString (getMainProcessorKey(), name); }
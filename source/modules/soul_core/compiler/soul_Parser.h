@@ -42,13 +42,59 @@ namespace Keyword
 
     SOUL_KEYWORDS (SOUL_DECLARE_TOKEN)
 
+    /** A perfect hash table of the keywords, indexed by a hash of their first, second
+        and last characters and their length.
+    */
+    struct HashTable
+    {
+        static constexpr uint32_t size = 128;
+
+        static constexpr uint32_t hash (const char* text, size_t length) noexcept
+        {
+            return ((uint32_t) (uint8_t) text[0]
+                     + 24u * (uint8_t) text[1]
+                     + 25u * (uint8_t) text[length - 1]
+                     + (uint32_t) length) & (size - 1);
+        }
+
+        TokenType tokens[size] = {};
+        uint8_t lengths[size] = {};
+        bool hasCollisions = false;
+
+        constexpr void add (TokenType token, size_t length)
+        {
+            auto h = hash (token.text, length);
+            hasCollisions = hasCollisions || lengths[h] != 0 || length < 2;
+            tokens[h] = token;
+            lengths[h] = (uint8_t) length;
+        }
+    };
+
+    static constexpr HashTable createHashTable()
+    {
+        HashTable table;
+        #define SOUL_ADD_KEYWORD(name, str) table.add (name, sizeof (str) - 1);
+        SOUL_KEYWORDS (SOUL_ADD_KEYWORD)
+        #undef SOUL_ADD_KEYWORD
+        return table;
+    }
+
+    static constexpr HashTable hashTable = createHashTable();
+    static_assert (! hashTable.hasCollisions, "The keyword hash function needs adjusting to avoid collisions");
+
     struct Matcher
     {
         static TokenType match (int len, UTF8Reader p) noexcept
         {
-            #define SOUL_COMPARE_KEYWORD(name, str) if (len == (int) sizeof (str) - 1 && p.startsWith (str)) return name;
-            SOUL_KEYWORDS (SOUL_COMPARE_KEYWORD)
-            #undef SOUL_COMPARE_KEYWORD
+            if (len < 2)
+                return {};
+
+            auto text = p.getAddress();
+            auto h = HashTable::hash (text, (size_t) len);
+
+            if (hashTable.lengths[h] == len && std::memcmp (text, hashTable.tokens[h].text, (size_t) len) == 0)
+                return hashTable.tokens[h];
+
             return {};
         }
     };
@@ -60,7 +106,8 @@ struct StandardOperatorMatcher
     static TokenType match (UTF8Reader& text) noexcept
     {
         auto p = text;
-        #define SOUL_COMPARE_OPERATOR(name, str) if (p.startsWith (str)) { text = p + (sizeof (str) - 1); return Operator::name; }
+        auto firstChar = *p.getAddress();
+        #define SOUL_COMPARE_OPERATOR(name, str) if (firstChar == str[0] && p.startsWith (str)) { text = p + (sizeof (str) - 1); return Operator::name; }
         SOUL_OPERATORS (SOUL_COMPARE_OPERATOR)
         #undef SOUL_COMPARE_OPERATOR
         return {};
@@ -109,7 +109,11 @@ private:
             }
         }
 
-        FullResolver (*this).visitObject (module);
+        {
+            SOUL_PROFILE_PHASE (FullResolver::getPassName());
+            FullResolver (*this).visitObject (module);
+        }
+
         module.isFullyResolved = true;
         return runStats;
     }
@@ -117,6 +121,7 @@ private:
     template <typename PassType>
     void tryPass (RunStats& runStats, bool ignoreErrors)
     {
+        SOUL_PROFILE_PHASE (PassType::getPassName());
         PassType pass (*this, ignoreErrors);
         pass.performPass();
         runStats.numFailures += pass.numFails;
@@ -1402,11 +1407,57 @@ private:
                                                                               const AST::QualifiedIdentifier& name)
         {
             auto argTypes = call.getArgumentTypes();
+            ArrayWithPreallocation<PossibleFunction, 4> results;
+
+            for (auto& f : getOverloadSet (call, name, argTypes.size()))
+                results.push_back (PossibleFunction (*f, argTypes));
+
+            return results;
+        }
+
+        //==============================================================================
+        /** The functions with a given name and number of arguments that are visible from
+            a module. Only modules can declare functions, so every call made from inside
+            the same module with the same name will find the same set, and this is cached
+            for the duration of the pass. Anything in the pass which adds or removes a
+            function must call functionListChanged() to clear the cache.
+        */
+        struct OverloadSet
+        {
+            AST::ModuleBasePtr module;
+            IdentifierPath path;
+            size_t numArgs;
+            ArrayWithPreallocation<AST::FunctionPtr, 4> functions;
+        };
+
+        std::unordered_multimap<size_t, OverloadSet> overloadSetCache;
+
+        void functionListChanged (AST::ModuleBase& m)
+        {
+            m.invalidateNameIndex();
+            overloadSetCache.clear();
+        }
+
+        ArrayView<AST::FunctionPtr> getOverloadSet (const AST::CallOrCast& call, const AST::QualifiedIdentifier& name, size_t numArgs)
+        {
+            auto callerModule = call.getParentScope()->findModule();
+            auto hash = std::hash<AST::ModuleBasePtr>() (callerModule) ^ (numArgs * 31);
+
+            for (auto& section : name.path.pathSections)
+                hash = hash * 65599 + std::hash<Identifier>() (section);
+
+            for (auto range = overloadSetCache.equal_range (hash); range.first != range.second; ++range.first)
+            {
+                auto& set = range.first->second;
+
+                if (set.module == callerModule && set.numArgs == numArgs && set.path == name.path)
+                    return set.functions;
+            }
 
             AST::Scope::NameSearch search;
             search.partiallyQualifiedPath = name.path;
             search.stopAtFirstScopeWithResults = false;
-            search.requiredNumFunctionArgs = (int) argTypes.size();
+            search.requiredNumFunctionArgs = (int) numArgs;
             search.findVariables = false;
             search.findTypes = false;
             search.findFunctions = true;
@@ -1421,14 +1472,14 @@ private:
                 call.getParentScope()->performFullNameSearch (search, nullptr);
             }
 
-            ArrayWithPreallocation<PossibleFunction, 4> results;
+            OverloadSet newSet { callerModule, name.path, numArgs, {} };
 
             for (auto& i : search.itemsFound)
                 if (auto f = cast<AST::Function> (i))
                     if (f->orginalGenericFunction == nullptr)
-                        results.push_back (PossibleFunction (*f, argTypes));
+                        newSet.functions.push_back (f);
 
-            return results;
+            return overloadSetCache.emplace (hash, std::move (newSet))->second.functions;
         }
 
         static size_t countNumberOfExactMatches (ArrayView<PossibleFunction> matches)
@@ -1673,6 +1724,9 @@ private:
             newFunction->name = specialisedFunctionName;
             newFunction->orginalGenericFunction = genericFunction;
 
+            if (auto parentModule = dynamic_cast<AST::ModuleBase*> (parentScope))
+                functionListChanged (*parentModule);
+
             SOUL_ASSERT (callerArgumentTypes.size() == newFunction->parameters.size());
 
             if (! resolveGenericFunctionTypes (call, genericFunction, *newFunction, callerArgumentTypes, shouldIgnoreErrors))
@@ -1680,6 +1734,7 @@ private:
                 auto parentModule = dynamic_cast<AST::ModuleBase*> (genericFunction.getParentScope());
                 SOUL_ASSERT (parentModule != nullptr);
                 removeItem (*parentModule->getFunctionList(), newFunction);
+                functionListChanged (*parentModule);
                 return {};
             }
 
@@ -43,6 +43,50 @@ SourceCodeText::Ptr SourceCodeText::createInternal (std::string name, std::strin
     return Ptr (*new SourceCodeText (std::move (name), std::move (text), true));
 }
 
+void SourceCodeText::buildLineStarts() const
+{
+    lineStarts.push_back ({ 0, true });
+
+    for (size_t i = 0; i < content.length(); ++i)
+    {
+        auto c = static_cast<uint8_t> (content[i]);
+
+        if (c == '\n')
+            lineStarts.push_back ({ static_cast<uint32_t> (i + 1), true });
+        else if (c >= 0x80)
+            lineStarts.back().isASCII = false;
+    }
+}
+
+SourceCodeText::LineAndColumn SourceCodeText::getLineAndColumn (const char* position) const
+{
+    std::call_once (lineStartsBuilt, [this] { buildLineStarts(); });
+
+    auto start = content.c_str();
+
+    if (position <= start)
+        return { 1, 1 };
+
+    auto offset = static_cast<uint32_t> (std::min (static_cast<size_t> (position - start), content.length()));
+
+    auto nextLine = std::upper_bound (lineStarts.begin(), lineStarts.end(), offset,
+                                      [] (uint32_t o, const LineStart& l) { return o < l.offset; });
+
+    auto& line = *(nextLine - 1);
+    auto lineNumber = static_cast<uint32_t> (nextLine - lineStarts.begin());
+
+    if (line.isASCII)
+        return { lineNumber, offset - line.offset + 1 };
+
+    uint32_t column = 1;
+
+    for (auto i = line.offset; i < offset; ++i)
+        if ((static_cast<uint8_t> (content[i]) & 0xc0) != 0x80)
+            ++column;
+
+    return { lineNumber, column };
+}
+
 //==============================================================================
 CodeLocation::CodeLocation (SourceCodeText::Ptr code)  : sourceCode (std::move (code)), location (sourceCode->utf8) {}
 
@@ -84,15 +128,7 @@ CodeLocation::LineAndColumn CodeLocation::getLineAndColumn() const
     if (sourceCode == nullptr)
         return { 0, 0 };
 
-    LineAndColumn lc = { 1, 1 };
-
-    for (auto i = sourceCode->utf8; i < location && ! i.isEmpty(); ++i)
-    {
-        ++lc.column;
-        if (*i == '\n')  { lc.column = 1; lc.line++; }
-    }
-
-    return lc;
+    return sourceCode->getLineAndColumn (location.getAddress());
 }
 
 std::string CodeLocation::getSourceLine() const
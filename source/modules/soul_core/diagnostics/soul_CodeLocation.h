@@ -34,10 +34,33 @@ struct SourceCodeText  final : public RefCountedObject
     const UTF8Reader utf8;
     const bool isInternal;
 
+    struct LineAndColumn
+    {
+        uint32_t line, column;
+    };
+
+    /** Returns the 1-based line and column of a position within the content, where the
+        column is counted in unicode characters.
+        The first call builds an index of where each line starts, so that looking up
+        lots of positions in a large file doesn't mean re-scanning it every time.
+    */
+    LineAndColumn getLineAndColumn (const char* position) const;
+
 private:
     SourceCodeText() = delete;
     SourceCodeText (const SourceCodeText&) = delete;
     SourceCodeText (std::string, std::string, bool internal);
+
+    struct LineStart
+    {
+        uint32_t offset;
+        bool isASCII;
+    };
+
+    mutable std::vector<LineStart> lineStarts;
+    mutable std::once_flag lineStartsBuilt;
+
+    void buildLineStarts() const;
 };
 
 
@@ -62,10 +85,7 @@ struct CodeLocation   final
     void emitMessage (CompileMessage) const;
     [[noreturn]] void throwError (CompileMessage) const;
 
-    struct LineAndColumn
-    {
-        uint32_t line, column;
-    };
+    using LineAndColumn = SourceCodeText::LineAndColumn;
 
     bool isEmpty() const;
     std::string getFilename() const;
@@ -0,0 +1,161 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#if ! SOUL_INSIDE_CORE_CPP
+ #error "Don't add this cpp file to your build, it gets included indirectly by soul_core.cpp"
+#endif
+
+namespace soul
+{
+
+static thread_local CompileProfiler* activeProfiler = nullptr;
+
+CompileProfiler::CompileProfiler()
+    : previousProfiler (activeProfiler), startTime (clock::now())
+{
+    activeProfiler = this;
+    PoolAllocator::startCountingAllocations();
+}
+
+CompileProfiler::~CompileProfiler()
+{
+    SOUL_ASSERT (activeProfiler == this);
+    PoolAllocator::stopCountingAllocations();
+    activeProfiler = previousProfiler;
+}
+
+double CompileProfiler::getSecondsSinceStart() const
+{
+    return std::chrono::duration<double> (clock::now() - startTime).count();
+}
+
+size_t CompileProfiler::startPhase (const char* name)
+{
+    auto& stats = PoolAllocator::getThreadStatistics();
+
+    Phase phase;
+    phase.name = name;
+    phase.parentIndex = openPhases.empty() ? -1 : static_cast<int> (openPhases.back());
+    phase.depth = static_cast<uint32_t> (openPhases.size());
+    phase.durationSeconds = 0;
+
+    // While a phase is open, these hold the counter values at its start
+    phase.objectsAllocated = stats.numObjects;
+    phase.bytesAllocated = stats.numBytes;
+
+    auto index = phases.size();
+    openPhases.push_back (index);
+    phase.startSeconds = getSecondsSinceStart();
+    phases.push_back (std::move (phase));
+    return index;
+}
+
+void CompileProfiler::endPhase (size_t index)
+{
+    auto& stats = PoolAllocator::getThreadStatistics();
+    auto& phase = phases[index];
+
+    phase.durationSeconds = getSecondsSinceStart() - phase.startSeconds;
+    phase.objectsAllocated = stats.numObjects - phase.objectsAllocated;
+    phase.bytesAllocated = stats.numBytes - phase.bytesAllocated;
+
+    SOUL_ASSERT (! openPhases.empty() && openPhases.back() == index);
+    openPhases.pop_back();
+}
+
+double CompileProfiler::getTotalSecondsFor (const std::string& phaseName) const
+{
+    double total = 0;
+
+    for (auto& p : phases)
+        if (p.name == phaseName)
+            total += p.durationSeconds;
+
+    return total;
+}
+
+static std::string toMicroseconds (double seconds)
+{
+    return std::to_string (std::llround (seconds * 1.0e6));
+}
+
+static std::string getPhaseJSONProperties (const CompileProfiler::Phase& p)
+{
+    return "\"name\": " + addDoubleQuotes (p.name)
+            + ", \"start_us\": " + toMicroseconds (p.startSeconds)
+            + ", \"duration_us\": " + toMicroseconds (p.durationSeconds)
+            + ", \"objects\": " + std::to_string (p.objectsAllocated)
+            + ", \"bytes\": " + std::to_string (p.bytesAllocated);
+}
+
+std::string CompileProfiler::toJSON() const
+{
+    std::vector<std::vector<size_t>> children (phases.size() + 1);
+
+    for (size_t i = 0; i < phases.size(); ++i)
+        children[static_cast<size_t> (phases[i].parentIndex + 1)].push_back (i);
+
+    std::function<std::string(const std::vector<size_t>&)> printPhases = [&] (const std::vector<size_t>& indexes)
+    {
+        std::vector<std::string> items;
+
+        for (auto i : indexes)
+        {
+            auto& childIndexes = children[i + 1];
+
+            items.push_back ("{ " + getPhaseJSONProperties (phases[i])
+                               + (childIndexes.empty() ? std::string() : ", \"phases\": " + printPhases (childIndexes)) + " }");
+        }
+
+        return "[ " + joinStrings (items, ", ") + " ]";
+    };
+
+    return "{ \"phases\": " + printPhases (children.front()) + " }";
+}
+
+std::string CompileProfiler::toChromeTrace() const
+{
+    std::vector<std::string> events;
+
+    for (auto& p : phases)
+        events.push_back ("{ \"name\": " + addDoubleQuotes (p.name)
+                            + ", \"cat\": \"compile\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+                            + ", \"ts\": " + toMicroseconds (p.startSeconds)
+                            + ", \"dur\": " + toMicroseconds (p.durationSeconds)
+                            + ", \"args\": { \"objects\": " + std::to_string (p.objectsAllocated)
+                            + ", \"bytes\": " + std::to_string (p.bytesAllocated) + " } }");
+
+    return "{ \"traceEvents\": [\n  " + joinStrings (events, ",\n  ") + "\n] }\n";
+}
+
+//==============================================================================
+CompileProfiler::ScopedPhase::ScopedPhase (const char* name)  : profiler (activeProfiler)
+{
+    if (profiler != nullptr)
+        index = profiler->startPhase (name);
+}
+
+CompileProfiler::ScopedPhase::~ScopedPhase()
+{
+    if (profiler != nullptr)
+        profiler->endPhase (index);
+}
+
+} // namespace soul
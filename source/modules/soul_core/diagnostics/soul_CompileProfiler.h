@@ -0,0 +1,104 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+namespace soul
+{
+
+//==============================================================================
+/**
+    Records a hierarchical breakdown of where the time and memory goes during a compile.
+
+    While a CompileProfiler exists, it records every SOUL_PROFILE_PHASE scope that runs on
+    the thread which created it. Profilers can be nested, in which case the innermost
+    one receives the phases. Each phase records its wall-clock time and the number of
+    objects and bytes that PoolAllocators allocated on the thread while it ran. The
+    results can be exported as JSON, or in the Chrome trace-event format used by
+    chrome://tracing and Perfetto.
+
+    When no profiler is active, a phase costs one thread-local read.
+*/
+class CompileProfiler  final
+{
+public:
+    CompileProfiler();
+    ~CompileProfiler();
+
+    CompileProfiler (const CompileProfiler&) = delete;
+    CompileProfiler& operator= (const CompileProfiler&) = delete;
+
+    struct Phase
+    {
+        std::string name;
+        int parentIndex;        // index of the enclosing phase, or -1 for a top-level phase
+        uint32_t depth;
+        double startSeconds;    // relative to the creation of the profiler
+        double durationSeconds;
+        uint64_t objectsAllocated, bytesAllocated;
+    };
+
+    /** Returns the recorded phases in the order they started. */
+    const std::vector<Phase>& getPhases() const     { return phases; }
+
+    /** Returns the total time of all the phases with this name. */
+    double getTotalSecondsFor (const std::string& phaseName) const;
+
+    /** Returns the phases as a tree of nested JSON objects. */
+    std::string toJSON() const;
+
+    /** Returns the phases as a JSON trace-event file, which can be loaded into
+        chrome://tracing or Perfetto.
+    */
+    std::string toChromeTrace() const;
+
+    //==============================================================================
+    /** Marks the duration of a phase. Use the SOUL_PROFILE_PHASE macro rather than
+        creating one of these directly.
+    */
+    struct ScopedPhase  final
+    {
+        ScopedPhase (const char* name);
+        ~ScopedPhase();
+
+    private:
+        CompileProfiler* profiler;
+        size_t index = 0;
+    };
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    CompileProfiler* const previousProfiler;
+    const clock::time_point startTime;
+    std::vector<Phase> phases;
+    std::vector<size_t> openPhases;
+
+    size_t startPhase (const char* name);
+    void endPhase (size_t index);
+    double getSecondsSinceStart() const;
+};
+
+#define SOUL_PROFILE_PHASE_NAME2(line)  profilePhase_ ## line
+#define SOUL_PROFILE_PHASE_NAME(line)   SOUL_PROFILE_PHASE_NAME2(line)
+
+/** Records the rest of the current scope as a phase in the thread's active CompileProfiler. */
+#define SOUL_PROFILE_PHASE(name) \
+    const soul::CompileProfiler::ScopedPhase SOUL_PROFILE_PHASE_NAME(__LINE__) (name);
+
+} // namespace soul
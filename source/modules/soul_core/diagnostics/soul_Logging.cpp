@@ -50,6 +50,7 @@ void Logger::setLogFunction (LoggingFunction f)
     auto& holder = getCallbackHolder();
     std::lock_guard<std::mutex> g (holder.lock);
     holder.callback = f;
+    holder.isEnabled = (f != nullptr);
 }
 
 void Logger::clearLogFunction()
@@ -59,9 +60,9 @@ void Logger::clearLogFunction()
 
 bool Logger::isLoggingEnabled() noexcept
 {
-    auto& holder = getCallbackHolder();
-    std::lock_guard<std::mutex> g (holder.lock);
-    return holder.callback != nullptr;
+    // This is called by every SOUL_LOG, so it avoids taking the lock, which would
+    // otherwise be contended when several threads are compiling at once
+    return getCallbackHolder().isEnabled.load (std::memory_order_relaxed);
 }
 
 Logger::LoggerHolder& Logger::getCallbackHolder()
@@ -24,6 +24,7 @@ namespace soul
 //==============================================================================
 /**
     Channels general log messages through a customisable callback function.
+    All of its methods are thread-safe, and calls to the callback are serialised.
 */
 class Logger  final
 {
@@ -64,6 +65,7 @@ private:
     {
         std::mutex lock;
         LoggingFunction callback;
+        std::atomic<bool> isEnabled { false };
     };
 
     static LoggerHolder& getCallbackHolder();
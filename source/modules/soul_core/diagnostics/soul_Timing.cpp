@@ -73,6 +73,156 @@ float CPULoadMeasurer::getCurrentLoad() const
    #endif
 }
 
+//==============================================================================
+RenderProfiler::RenderProfiler()                { clear(); }
+
+void RenderProfiler::setEnabled (bool b)        { enabled.store (b); }
+bool RenderProfiler::isEnabled() const          { return enabled.load(); }
+void RenderProfiler::reset()                    { resetPending.store (true); }
+
+void RenderProfiler::clear()
+{
+    for (auto& b : bins)
+        b.store (0, std::memory_order_relaxed);
+
+    numBlocks.store (0, std::memory_order_relaxed);
+    numFrames.store (0, std::memory_order_relaxed);
+    totalCycles.store (0, std::memory_order_relaxed);
+    totalNanoseconds.store (0, std::memory_order_relaxed);
+    maxNanoseconds.store (0, std::memory_order_relaxed);
+}
+
+uint64_t RenderProfiler::readCycleCounter() noexcept
+{
+   #if SOUL_INTEL && (defined (__GNUC__) || defined (__clang__))
+    return __builtin_ia32_rdtsc();
+   #elif SOUL_INTEL && defined (_MSC_VER)
+    return __rdtsc();
+   #else
+    return (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+   #endif
+}
+
+int RenderProfiler::getBinIndex (uint64_t nanoseconds)
+{
+    if (nanoseconds == 0)
+        return 0;
+
+    int exponent = 0;
+    auto mantissa = std::frexp ((double) nanoseconds, std::addressof (exponent));
+    auto bin = (exponent - 1) * binsPerOctave + (int) ((mantissa - 0.5) * (2 * binsPerOctave));
+
+    return std::min (bin, numBins - 1);
+}
+
+double RenderProfiler::getBinUpperLimitSeconds (int bin)
+{
+    auto octave = bin / binsPerOctave;
+    auto step = bin % binsPerOctave;
+
+    return std::ldexp (1.0 + (step + 1) / (double) binsPerOctave, octave) * 1.0e-9;
+}
+
+// Only the render thread writes to the counters, so plain load/store pairs are
+// enough here, and avoid the cost of a locked read-modify-write.
+void RenderProfiler::addBlock (uint64_t nanoseconds, uint64_t cycles, uint32_t frames)
+{
+    auto increment = [] (auto& counter, uint64_t amount)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    };
+
+    auto& bin = bins[(size_t) getBinIndex (nanoseconds)];
+    bin.store (bin.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    increment (numFrames, frames);
+    increment (totalCycles, cycles);
+    increment (totalNanoseconds, nanoseconds);
+
+    if (nanoseconds > maxNanoseconds.load (std::memory_order_relaxed))
+        maxNanoseconds.store (nanoseconds, std::memory_order_relaxed);
+
+    numBlocks.store (numBlocks.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+RenderProfiler::ScopedBlock::ScopedBlock (RenderProfiler& p, uint32_t frames) noexcept  : numFrames (frames)
+{
+    if (p.enabled.load (std::memory_order_relaxed))
+    {
+        if (p.resetPending.exchange (false))
+            p.clear();
+
+        profiler = std::addressof (p);
+        startTime = std::chrono::steady_clock::now();
+        startCycles = readCycleCounter();
+    }
+}
+
+RenderProfiler::ScopedBlock::~ScopedBlock()
+{
+    if (profiler != nullptr)
+    {
+        auto cycles = readCycleCounter() - startCycles;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - startTime);
+
+        profiler->addBlock ((uint64_t) elapsed.count(), cycles, numFrames);
+    }
+}
+
+double RenderProfiler::getPercentileSeconds (uint64_t totalBlocks, double proportion) const
+{
+    auto target = (uint64_t) std::ceil (proportion * (double) totalBlocks);
+    uint64_t count = 0;
+
+    for (int i = 0; i < numBins; ++i)
+    {
+        count += bins[(size_t) i].load (std::memory_order_relaxed);
+
+        if (count >= target)
+            return getBinUpperLimitSeconds (i);
+    }
+
+    return getBinUpperLimitSeconds (numBins - 1);
+}
+
+RenderProfiler::Statistics RenderProfiler::getStatistics() const
+{
+    Statistics s;
+
+    if (resetPending.load())
+        return s;
+
+    s.numBlocks = numBlocks.load (std::memory_order_acquire);
+
+    if (s.numBlocks == 0)
+        return s;
+
+    s.numFrames      = numFrames.load (std::memory_order_relaxed);
+    s.totalCycles    = totalCycles.load (std::memory_order_relaxed);
+    s.maxSeconds     = (double) maxNanoseconds.load (std::memory_order_relaxed) * 1.0e-9;
+    s.averageSeconds = (double) totalNanoseconds.load (std::memory_order_relaxed) * 1.0e-9 / (double) s.numBlocks;
+
+    // The binned estimates are clamped to the maximum, which is known exactly
+    s.p50Seconds = std::min (s.maxSeconds, getPercentileSeconds (s.numBlocks, 0.5));
+    s.p99Seconds = std::min (s.maxSeconds, getPercentileSeconds (s.numBlocks, 0.99));
+
+    return s;
+}
+
+double RenderProfiler::Statistics::getAverageCyclesPerFrame() const
+{
+    return numFrames == 0 ? 0.0 : (double) totalCycles / (double) numFrames;
+}
+
+std::string RenderProfiler::Statistics::getDescription() const
+{
+    return "blocks: " + std::to_string (numBlocks)
+            + ", p50: " + getDescriptionOfTimeInSeconds (p50Seconds)
+            + ", p99: " + getDescriptionOfTimeInSeconds (p99Seconds)
+            + ", max: " + getDescriptionOfTimeInSeconds (maxSeconds)
+            + ", cycles/frame: " + toStringWithDecPlaces (getAverageCyclesPerFrame(), 1);
+}
+
 float getBelaLoadFromString (const std::string& input)
 {
     for (auto& l : splitIntoLines (input))
@@ -64,5 +64,78 @@ private:
     double runningProportion = 0;
 };
 
+//==============================================================================
+/**
+    Collects a histogram of render-block durations and a running total of CPU cycles,
+    for profiling a real-time render loop.
+
+    The render thread wraps each block in a ScopedBlock. This does nothing unless
+    profiling has been enabled, and even then it only performs relaxed atomic stores,
+    so it never locks or allocates. Only one thread may render into a given profiler,
+    but any other thread can call getStatistics() at any time to take a snapshot.
+
+    Block times are binned logarithmically with eight bins per octave, so the
+    percentiles that are reported are accurate to within about 9%. The maximum is exact.
+*/
+struct RenderProfiler
+{
+    RenderProfiler();
+
+    /** Profiling is off by default, so that a ScopedBlock costs just one atomic load. */
+    void setEnabled (bool shouldBeEnabled);
+    bool isEnabled() const;
+
+    /** Clears the counters. This can be called from any thread: the render thread
+        performs the actual clear at the start of its next block.
+    */
+    void reset();
+
+    /** Measures the time spent rendering one block of frames. */
+    struct ScopedBlock
+    {
+        ScopedBlock (RenderProfiler&, uint32_t numFrames) noexcept;
+        ~ScopedBlock();
+
+    private:
+        RenderProfiler* profiler = nullptr;
+        uint32_t numFrames;
+        uint64_t startCycles = 0;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    struct Statistics
+    {
+        uint64_t numBlocks = 0, numFrames = 0, totalCycles = 0;
+        double p50Seconds = 0, p99Seconds = 0, maxSeconds = 0, averageSeconds = 0;
+
+        double getAverageCyclesPerFrame() const;
+        std::string getDescription() const;
+    };
+
+    /** Returns a snapshot of the counters. As the render thread may be updating them
+        while it's taken, the snapshot can be off by one block between fields.
+    */
+    Statistics getStatistics() const;
+
+    /** Returns the CPU's timestamp counter where there is one, or a high-resolution
+        clock tick count otherwise.
+    */
+    static uint64_t readCycleCounter() noexcept;
+
+private:
+    static constexpr int binsPerOctave = 8, numOctaves = 36, numBins = binsPerOctave * numOctaves;
+
+    std::atomic<bool> enabled { false }, resetPending { false };
+    std::array<std::atomic<uint32_t>, numBins> bins;
+    std::atomic<uint64_t> numBlocks { 0 }, numFrames { 0 }, totalCycles { 0 },
+                          totalNanoseconds { 0 }, maxNanoseconds { 0 };
+
+    void clear();
+    void addBlock (uint64_t nanoseconds, uint64_t cycles, uint32_t frames);
+    static int getBinIndex (uint64_t nanoseconds);
+    static double getBinUpperLimitSeconds (int bin);
+    double getPercentileSeconds (uint64_t totalBlocks, double proportion) const;
+};
+
 
 } // namespace soul
@@ -128,7 +128,13 @@ struct Program::ProgramImpl  : public RefCountedObject
             c.clone();
 
         for (auto& c : constantTable)
-            newProgram.pimpl->constantTable.addItem ({ c.handle, std::make_unique<Value> (cloneValue (structMappings, *c.value)) });
+        {
+            // Shared values are immutable and can't contain structs, so the clone can use the same copy
+            if (SharedValueStore::canBeShared (*c.value))
+                newProgram.pimpl->constantTable.addItem ({ c.handle, c.value });
+            else
+                newProgram.pimpl->constantTable.addItem ({ c.handle, std::make_shared<const Value> (cloneValue (structMappings, *c.value)) });
+        }
 
         return newProgram;
     }
@@ -269,6 +275,116 @@ std::string Program::getHash() const
     return hash.toString();
 }
 
+//==============================================================================
+struct Program::StructuralHasher
+{
+    StructuralHasher (const Program& p) : program (p) {}
+
+    const Program& program;
+    HashBuilder hash;
+    std::vector<const void*> visited;
+
+    void addModule (const Module& m)
+    {
+        if (! markAsVisited (std::addressof (m)))
+            return;
+
+        hash << heart::Printer::getDump (program, m);
+
+        for (auto& v : m.stateVariables)
+            if (v->isExternal())
+                addConstant (v->externalHandle);
+
+        for (auto& f : m.functions)
+            addCalledFunctions (*f);
+
+        for (auto& i : m.processorInstances)
+            if (auto source = program.getModuleWithName (i->sourceName))
+                addModule (*source);
+    }
+
+    void addFunction (const heart::Function& f)
+    {
+        if (! markAsVisited (std::addressof (f)))
+            return;
+
+        auto module = findModuleContaining (f);
+        SOUL_ASSERT (module != nullptr);
+
+        hash << heart::Printer::getDump (program, *module, f);
+
+        for (auto& v : module->stateVariables)
+            if (v->isExternal())
+                addConstant (v->externalHandle);
+
+        addCalledFunctions (f);
+    }
+
+    void addCalledFunctions (const heart::Function& f)
+    {
+        for (auto& b : f.blocks)
+        {
+            for (auto s : b->statements)
+            {
+                if (auto fc = cast<heart::FunctionCall> (*s))
+                    if (fc->function != nullptr)
+                        addFunction (*fc->function);
+
+                s->visitExpressions ([this] (heart::ExpressionPtr& e, heart::AccessType)
+                {
+                    if (auto pfc = cast<heart::PureFunctionCall> (e))
+                        addFunction (pfc->function);
+                });
+            }
+        }
+    }
+
+    void addConstant (ConstantTable::Handle handle)
+    {
+        if (auto value = program.getConstantTable().getValueForHandle (handle))
+        {
+            hash << value->getType().getDescription();
+
+            auto data = static_cast<const char*> (value->getPackedData());
+
+            for (size_t i = 0; i < value->getPackedDataSize(); ++i)
+                hash << data[i];
+        }
+    }
+
+    bool markAsVisited (const void* item)
+    {
+        if (contains (visited, item))
+            return false;
+
+        visited.push_back (item);
+        return true;
+    }
+
+    pool_ptr<Module> findModuleContaining (const heart::Function& f) const
+    {
+        for (auto& m : program.getModules())
+            if (contains (m->functions, std::addressof (f)))
+                return m;
+
+        return {};
+    }
+};
+
+std::string Program::getModuleHash (const Module& m) const
+{
+    StructuralHasher hasher (*this);
+    hasher.addModule (m);
+    return hasher.hash.toString();
+}
+
+std::string Program::getFunctionHash (const heart::Function& f) const
+{
+    StructuralHasher hasher (*this);
+    hasher.addFunction (f);
+    return hasher.hash.toString();
+}
+
 Module& Program::getMainProcessorOrThrowError() const
 {
     auto main = getMainProcessor();
@@ -88,6 +88,20 @@ public:
     /** Generates a repeatable hash code for the complete state of this program. */
     std::string getHash() const;
 
+    /** Generates a repeatable hash for the structure of one of this program's modules.
+        The hash covers the module's own code and declarations, the contents of any external
+        data that it has been linked to, and (recursively) any functions or processors that it
+        uses from other modules. Structurally identical modules in different programs will
+        produce the same hash, so it can be used as a key for sharing compiled code between them.
+    */
+    std::string getModuleHash (const Module&) const;
+
+    /** Generates a repeatable hash for the structure of a function in this program.
+        Like getModuleHash(), this also covers any functions that it calls, so that two
+        functions with the same hash can be treated as interchangeable.
+    */
+    std::string getFunctionHash (const heart::Function&) const;
+
     /** Provides access to the program's string dictionary */
     StringDictionary& getStringDictionary();
 
@@ -142,6 +156,7 @@ public:
 private:
     //==============================================================================
     struct ProgramImpl;
+    struct StructuralHasher;
     RefCountedPtr<ProgramImpl> pimpl;
 
     Program (ProgramImpl*);
@@ -72,7 +72,8 @@ namespace HEARTOperator
     {
         static TokenType match (UTF8Reader& text) noexcept
         {
-            #define SOUL_COMPARE_OPERATOR(name, str) if (text.advanceIfStartsWith (str)) return name;
+            auto firstChar = *text.getAddress();
+            #define SOUL_COMPARE_OPERATOR(name, str) if (firstChar == str[0] && text.advanceIfStartsWith (str)) return name;
             SOUL_HEART_OPERATORS (SOUL_COMPARE_OPERATOR)
             #undef SOUL_COMPARE_OPERATOR
             return {};
@@ -40,6 +40,24 @@ struct heart::Printer
         return out.toString();
     }
 
+    /** Prints a single module, in the same format that getDump() uses for it. */
+    static std::string getDump (const Program& p, const Module& m)
+    {
+        IndentedStream out;
+        PrinterStream (p, m, out).printAll();
+        return out.toString();
+    }
+
+    /** Prints a function, preceded by the declarations of the structs and state
+        variables in its module, which its body may refer to by name.
+    */
+    static std::string getDump (const Program& p, const Module& m, const heart::Function& f)
+    {
+        IndentedStream out;
+        PrinterStream (p, m, out).printFunctionWithContext (f);
+        return out.toString();
+    }
+
 private:
     struct PrinterStream
     {
@@ -88,6 +106,16 @@ private:
             out << blankLine;
         }
 
+        void printFunctionWithContext (const heart::Function& f)
+        {
+            for (auto& v : module.stateVariables)
+                allVisibleVariables.push_back (v->name);
+
+            printStructs();
+            printStateVariables();
+            printFunction (f);
+        }
+
         std::string getDescription (const std::vector<Type>& types)
         {
             if (types.size() == 1)
@@ -230,7 +258,7 @@ private:
                 printFunction (*f);
         }
 
-        void printFunction (heart::Function& f)
+        void printFunction (const heart::Function& f)
         {
             SOUL_ASSERT (f.name.isValid());
 
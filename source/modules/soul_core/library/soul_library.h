@@ -34,6 +34,16 @@ static inline CodeLocation getDefaultLibraryCode()
 
 }
 
+/** Contains the approximations in soul::intrinsics::fast. These are only compiled into
+    programs which use fast math, so that other programs don't pay for them.
+*/
+static inline CodeLocation getFastMathLibraryCode()
+{
+    return SourceCodeText::createInternal ("SOUL fast math library",
+                                           #include "soul_library_fastmath.h"
+                                           );
+}
+
 static inline const char* getSystemModuleCode (const std::string& moduleName)
 {
     if (moduleName == "soul.audio.utils") return
@@ -0,0 +1,146 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*  The following string literal is the part of the built-in library which the compiler
+    adds to a program only when it uses fast math. (See soul::getFastMathLibraryCode())
+
+    The intrinsics::fast namespace contains cheaper approximations of some of the
+    intrinsics. They're written without branches, so work lane-wise on float vectors
+    as well as on scalars, and can be inlined and vectorised by a performer.
+    Calls to the standard versions are redirected to these for any processor or
+    function with a [[fastMath]] annotation, or for the whole program if the
+    "fast_math" link option is set (see LinkOptions::setFastMath).
+
+    The error bounds given are for float32 values.
+*/
+R"library(
+
+namespace soul::intrinsics::fast
+{
+    /** Approximates sin() with an absolute error of less than 2.5e-7 for |n| < 1000, and
+        less than 1e-4 up to |n| < 4 million, beyond which the range reduction fails.
+    */
+    T sin<T> (T n)
+    {
+        static_assert ((T.isPrimitive || T.isVector) && T.primitiveType.isFloat, "sin() only works with floating point types");
+
+        let k = helpers::roundToInteger (n * T (1.0 / pi));
+        return helpers::getAlternatingSign (k) * helpers::sinPolynomial (helpers::reduceByMultipleOfPi (n, k));
+    }
+
+    /** Approximates cos() with the same accuracy as sin(). */
+    T cos<T> (T n)
+    {
+        static_assert ((T.isPrimitive || T.isVector) && T.primitiveType.isFloat, "cos() only works with floating point types");
+
+        let k = helpers::roundToInteger (n * T (1.0 / pi) - T (0.5));
+        return helpers::getAlternatingSign (k + T (1)) * helpers::sinPolynomial (helpers::reduceByMultipleOfPi (n, k + T (0.5)));
+    }
+
+    /** Approximates tan() as sin() / cos(). The relative error stays below 1e-6 except
+        within about 1e-3 of a pole.
+    */
+    T tan<T> (T n)
+    {
+        static_assert ((T.isPrimitive || T.isVector) && T.primitiveType.isFloat, "tan() only works with floating point types");
+        return soul::intrinsics::fast::sin (n) / soul::intrinsics::fast::cos (n);
+    }
+
+    /** Approximates exp() with a relative error of less than 7e-5 for n in [-87, 88], and
+        less than 3e-5 for |n| < 10.
+        This evaluates a polynomial at n / 256 and squares the result eight times, so that
+        no access to the bits of the float is needed. That only works within a limited range,
+        so the input is clamped to [-87, 88], where the result is a normal float32. Beyond
+        that, including for infinite inputs, the result saturates at about 1.6e-38 or 1.6e38
+        rather than reaching 0 or inf.
+    */
+    T exp<T> (T n)
+    {
+        static_assert ((T.isPrimitive || T.isVector) && T.primitiveType.isFloat, "exp() only works with floating point types");
+
+        let x = helpers::clampWithoutBranching (n, T (-87), T (88)) * T (1.0 / 256.0);
+        var r = T (1) + x * (T (1) + x * (T (1.0 / 2.0) + x * (T (1.0 / 6.0) + x * (T (1.0 / 24.0) + x * (T (1.0 / 120.0) + x * T (1.0 / 720.0))))));
+
+        r *= r;  r *= r;  r *= r;  r *= r;
+        r *= r;  r *= r;  r *= r;  r *= r;
+        return r;
+    }
+
+    /** Approximates tanh() using exp(), with an absolute error of less than 1.5e-5.
+        Large or infinite inputs of either sign saturate cleanly to +/-1.
+    */
+    T tanh<T> (T n)
+    {
+        static_assert ((T.isPrimitive || T.isVector) && T.primitiveType.isFloat, "tanh() only works with floating point types");
+        return T (1) - T (2) / (soul::intrinsics::fast::exp (n + n) + T (1));
+    }
+
+    /** Internal helpers for the approximations above, which aren't meant to be called directly. */
+    namespace helpers
+    {
+        /** Clamps a value to a range lane-wise, using the results of the comparisons as weights
+            of 0 or 1 instead of branching.
+            Multiplying an infinite input by a weight of 0 would give NaN, so the in-range term is
+            written as 1 / (1 / n), which is 0 rather than NaN when n is infinite. For values inside
+            the range it's within one ulp of n.
+        */
+        T clampWithoutBranching<T> (T n, T low, T high)
+        {
+            let isBelow = T (n < low);
+            let isAbove = T (n > high);
+            return isBelow * low + isAbove * high + (T (1) - isBelow - isAbove) / (T (1) / n + isBelow + isAbove);
+        }
+
+        /** Rounds to the nearest integer by adding and subtracting a constant which is large
+            enough to push the fractional bits out of the mantissa. Valid for |n| < 2^22 (float32)
+            or 2^51 (float64).
+        */
+        T roundToInteger<T> (T n)
+        {
+            let magic = T.primitiveType.isFloat64 ? T (6755399441055744.0) : T (12582912.0f);
+            return (n + magic) - magic;
+        }
+
+        /** For an integer-valued k, returns 1 if k is even and -1 if it's odd. */
+        T getAlternatingSign<T> (T k)
+        {
+            let isOdd = k - T (2) * roundToInteger (k * T (0.5) - T (0.25));
+            return T (1) - T (2) * isOdd;
+        }
+
+        /** Returns n - k * pi, using a two-part pi so that the first product is exact. */
+        T reduceByMultipleOfPi<T> (T n, T k)
+        {
+            return (n - k * T (3.140625)) - k * T (9.67653589793116e-4);
+        }
+
+        /** The Taylor series for sin() up to n^11, which is accurate to float32 precision
+            for |n| <= pi / 2.
+        */
+        T sinPolynomial<T> (T n)
+        {
+            let n2 = n * n;
+            return n * (T (1) + n2 * (T (-1.0 / 6.0) + n2 * (T (1.0 / 120.0) + n2 * (T (-1.0 / 5040.0)
+                         + n2 * (T (1.0 / 362880.0) + n2 * T (-1.0 / 39916800.0))))));
+        }
+    }
+}
+
+)library"
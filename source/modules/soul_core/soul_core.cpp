@@ -35,6 +35,10 @@
 
 #if SOUL_INTEL
  #include <xmmintrin.h>
+
+ #ifdef _MSC_VER
+  #include <intrin.h>
+ #endif
 #endif
 
 #ifdef __APPLE__
@@ -48,12 +52,15 @@
 #include "utilities/soul_StringUtilities.cpp"
 #include "utilities/soul_UTF8Reader.cpp"
 #include "utilities/soul_MiscUtilities.cpp"
+#include "utilities/soul_Resampler.cpp"
+#include "utilities/soul_ThreadPool.cpp"
 #include "utilities/soul_AudioDataGeneration.cpp"
 #include "utilities/soul_IndentedStream.cpp"
 #include "types/soul_Struct.cpp"
 #include "types/soul_StringDictionary.cpp"
 #include "types/soul_ConstantTable.cpp"
 #include "types/soul_Value.cpp"
+#include "types/soul_SharedValueStore.cpp"
 #include "types/soul_Annotation.cpp"
 #include "types/soul_EndpointType.cpp"
 #include "heart/soul_heart_Printer.h"
@@ -66,6 +73,7 @@
 #include "compiler/soul_ResolutionPass.h"
 #include "compiler/soul_HeartGenerator.h"
 #include "compiler/soul_Compiler.cpp"
+#include "compiler/soul_BatchCompiler.cpp"
 #include "heart/soul_Intrinsics.cpp"
 #include "heart/soul_ModuleCloner.h"
 #include "heart/soul_Module.cpp"
@@ -75,3 +83,4 @@
 #include "diagnostics/soul_Logging.cpp"
 #include "diagnostics/soul_CompileMessageList.cpp"
 #include "diagnostics/soul_Timing.cpp"
+#include "diagnostics/soul_CompileProfiler.cpp"
@@ -59,6 +59,8 @@
 #include <atomic>
 #include <limits>
 #include <condition_variable>
+#include <thread>
+#include <deque>
 #include <cassert>
 
 #include "utilities/soul_MiscUtilities.h"
@@ -97,10 +99,12 @@ namespace soul
 #include "utilities/soul_ChannelSets.h"
 #include "utilities/soul_FIFO.h"
 #include "utilities/soul_ChannelSetFIFO.h"
+#include "utilities/soul_ThreadPool.h"
 #include "utilities/soul_Resampler.h"
 
 #include "diagnostics/soul_Logging.h"
 #include "diagnostics/soul_Timing.h"
+#include "diagnostics/soul_CompileProfiler.h"
 #include "diagnostics/soul_CodeLocation.h"
 #include "diagnostics/soul_CompileMessageList.h"
 #include "diagnostics/soul_Errors.h"
@@ -111,6 +115,7 @@ namespace soul
 #include "types/soul_StringDictionary.h"
 #include "types/soul_ConstantTable.h"
 #include "types/soul_Value.h"
+#include "types/soul_SharedValueStore.h"
 #include "types/soul_Annotation.h"
 #include "types/soul_TypeRules.h"
 #include "types/soul_EndpointType.h"
@@ -128,6 +133,7 @@ namespace soul
 #include "compiler/soul_LinkOptions.h"
 #include "compiler/soul_AST.h"
 #include "compiler/soul_Compiler.h"
+#include "compiler/soul_BatchCompiler.h"
 
 #include "venue/soul_Endpoints.h"
 #include "venue/soul_Performer.h"
@@ -135,4 +141,5 @@ namespace soul
 
 #include "utilities/soul_EventQueue.h"
 #include "utilities/soul_AudioDataGeneration.h"
+#include "utilities/soul_SilenceDetector.h"
 #include "utilities/soul_SynchronousPerformerWrapper.h"
@@ -36,12 +36,25 @@ namespace soul
         if (! value.isValid())
             return 0;
 
+        if (SharedValueStore::canBeShared (value))
+        {
+            auto sharedValue = SharedValueStore::getInstance().getSharedValue (std::move (value));
+
+            for (auto& i : items)
+                if (i.value == sharedValue)
+                    return i.handle;
+
+            auto handle = nextIndex++;
+            items.push_back ({ handle, std::move (sharedValue) });
+            return handle;
+        }
+
         for (auto& i : items)
             if (value == *i.value)
                 return i.handle;
 
         auto handle = nextIndex++;
-        items.push_back ({ handle, std::make_unique<Value> (std::move (value)) });
+        items.push_back ({ handle, std::make_shared<const Value> (std::move (value)) });
         return handle;
     }
 
@@ -31,7 +31,10 @@ public:
 
     using Handle = std::intptr_t;
 
-    /** Adds a new Value to the set, and returns a handle for it. */
+    /** Adds a new Value to the set, and returns a handle for it.
+        Large arrays are placed in the SharedValueStore, so that tables which contain
+        identical data will all refer to the same copy of it.
+    */
     Handle getHandleForValue (Value);
 
     /** Attempts to return the value that was provided for this handle, or a nullptr
@@ -42,7 +45,7 @@ public:
     struct Item
     {
         Handle handle;
-        std::unique_ptr<Value> value;
+        std::shared_ptr<const Value> value;
     };
 
     const Item* begin() const;
@@ -0,0 +1,172 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#if ! SOUL_INSIDE_CORE_CPP
+ #error "Don't add this cpp file to your build, it gets included indirectly by soul_core.cpp"
+#endif
+
+namespace soul
+{
+
+SharedValueStore::SharedValueStore() = default;
+SharedValueStore::~SharedValueStore() = default;
+
+SharedValueStore& SharedValueStore::getInstance()
+{
+    static SharedValueStore store;
+    return store;
+}
+
+bool SharedValueStore::canBeShared (const Value& value)
+{
+    auto& type = value.getType();
+
+    return type.isFixedSizeArray()
+            && type.getArrayElementType().isPrimitiveOrVector()
+            && value.getPackedDataSize() >= minimumSharedSize;
+}
+
+uint64_t SharedValueStore::getContentHash (const Value& value)
+{
+    // A simple 64-bit multiply-and-rotate hash, which runs at close to memory bandwidth
+    // on large arrays. Collisions are harmless because matches are also compared in full.
+    auto data = static_cast<const uint8_t*> (value.getPackedData());
+    auto size = value.getPackedDataSize();
+    auto hash = (uint64_t) std::hash<std::string>() (value.getType().getDescription()) ^ (uint64_t) size;
+
+    auto mix = [&] (uint64_t chunk)
+    {
+        hash ^= chunk * 0x9e3779b97f4a7c15ull;
+        hash = ((hash << 31) | (hash >> 33)) * 0xbf58476d1ce4e5b9ull;
+    };
+
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+        mix (readUnaligned<uint64_t> (data + i));
+
+    for (; i < size; ++i)
+        mix (data[i]);
+
+    return hash;
+}
+
+std::shared_ptr<const Value> SharedValueStore::getSharedValue (Value value)
+{
+    SOUL_ASSERT (canBeShared (value));
+    auto hash = getContentHash (value);
+
+    std::lock_guard<decltype(lock)> l (lock);
+    auto& bucket = values[hash];
+
+    for (auto& existing : bucket)
+    {
+        if (auto v = existing.lock())
+        {
+            if (*v == value)
+            {
+                retain (v);
+                return v;
+            }
+        }
+    }
+
+    auto newValue = std::make_shared<const Value> (std::move (value));
+    bucket.push_back (newValue);
+    retain (newValue);
+
+    if (++numAdditionsSinceLastPurge >= 32)
+        removeExpiredValues();
+
+    return newValue;
+}
+
+void SharedValueStore::setRetainedDataLimit (uint64_t maxBytes)
+{
+    std::lock_guard<decltype(lock)> l (lock);
+    maxRetainedDataSize = maxBytes;
+    trimRetainedValues();
+    removeExpiredValues();
+}
+
+size_t SharedValueStore::getNumSharedValues() const
+{
+    std::lock_guard<decltype(lock)> l (lock);
+    size_t num = 0;
+
+    for (auto& bucket : values)
+        for (auto& v : bucket.second)
+            if (! v.expired())
+                ++num;
+
+    return num;
+}
+
+uint64_t SharedValueStore::getTotalSharedDataSize() const
+{
+    std::lock_guard<decltype(lock)> l (lock);
+    uint64_t total = 0;
+
+    for (auto& bucket : values)
+        for (auto& v : bucket.second)
+            if (auto value = v.lock())
+                total += value->getPackedDataSize();
+
+    return total;
+}
+
+void SharedValueStore::retain (std::shared_ptr<const Value> value)
+{
+    if (maxRetainedDataSize == 0)
+        return;
+
+    if (removeFirst (retainedValues, [&] (const std::shared_ptr<const Value>& v) { return v == value; }))
+        retainedDataSize -= value->getPackedDataSize();
+
+    retainedDataSize += value->getPackedDataSize();
+    retainedValues.push_back (std::move (value));
+    trimRetainedValues();
+}
+
+void SharedValueStore::trimRetainedValues()
+{
+    while (retainedDataSize > maxRetainedDataSize && ! retainedValues.empty())
+    {
+        retainedDataSize -= retainedValues.front()->getPackedDataSize();
+        retainedValues.pop_front();
+    }
+}
+
+void SharedValueStore::removeExpiredValues()
+{
+    numAdditionsSinceLastPurge = 0;
+
+    for (auto bucket = values.begin(); bucket != values.end();)
+    {
+        removeIf (bucket->second, [] (const std::weak_ptr<const Value>& v) { return v.expired(); });
+
+        if (bucket->second.empty())
+            bucket = values.erase (bucket);
+        else
+            ++bucket;
+    }
+}
+
+} // namespace soul
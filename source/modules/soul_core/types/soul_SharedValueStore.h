@@ -0,0 +1,83 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+namespace soul
+{
+
+//==============================================================================
+/**
+    A process-wide store of large, immutable Values, which lets multiple ConstantTables
+    share a single copy of identical data (e.g. the same sample set loaded by several
+    instances of a patch).
+
+    Values are matched by content, and the store only holds weak references to them, so
+    each one is freed when the last table that uses it is deleted. A retention limit can
+    also be set, to keep recently-released values around for a while in case they're
+    about to be used again (e.g. when a patch is being reloaded).
+
+    All methods are thread-safe.
+*/
+class SharedValueStore
+{
+public:
+    SharedValueStore();
+    ~SharedValueStore();
+
+    /** Returns the store that is shared by everything in this process. */
+    static SharedValueStore& getInstance();
+
+    /** Values smaller than this aren't worth sharing, so are left in their own tables. */
+    static constexpr size_t minimumSharedSize = 4096;
+
+    /** Returns true if this is a value that the store can hold. Only large arrays of
+        primitives or vectors are shared, because anything that may contain constant
+        table handles or structs can only be interpreted in the context of its own program.
+    */
+    static bool canBeShared (const Value&);
+
+    /** Returns a shared copy of the given value. If an identical value is already in the
+        store, then that one is returned and the one passed in is discarded.
+    */
+    std::shared_ptr<const Value> getSharedValue (Value);
+
+    /** Sets the total size of recently-released values which should be kept alive. */
+    void setRetainedDataLimit (uint64_t maxBytes);
+
+    /** Returns the number of values currently being shared. */
+    size_t getNumSharedValues() const;
+
+    /** Returns the total packed size of the values currently being shared. */
+    uint64_t getTotalSharedDataSize() const;
+
+private:
+    //==============================================================================
+    mutable std::mutex lock;
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const Value>>> values;
+    std::deque<std::shared_ptr<const Value>> retainedValues;
+    uint64_t retainedDataSize = 0, maxRetainedDataSize = 0;
+    uint32_t numAdditionsSinceLastPurge = 0;
+
+    static uint64_t getContentHash (const Value&);
+    void retain (std::shared_ptr<const Value>);
+    void trimRetainedValues();
+    void removeExpiredValues();
+};
+
+} // namespace soul
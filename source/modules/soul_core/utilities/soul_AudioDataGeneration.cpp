@@ -117,15 +117,35 @@ namespace WaveGenerators
     };
 }
 
-Value convertAudioDataToType (const Type& requestedType, ConstantTable& constantTable,
-                              DiscreteChannelSet<float> data, double sampleRate)
+static Value createInterleavedFloatArray (uint32_t targetNumChannels, uint32_t numFrames, const AudioDataFillFn& fillData)
+{
+    auto v = Value::zeroInitialiser (Type::createVector (PrimitiveType::float32, targetNumChannels).createArray (numFrames));
+    fillData ({ static_cast<float*> (v.getPackedData()), targetNumChannels, numFrames, targetNumChannels });
+    return v;
+}
+
+static InterleavedChannelSet<float> getInterleavedChannelSet (const Value& interleavedArray)
+{
+    auto& type = interleavedArray.getType();
+    SOUL_ASSERT (type.isFixedSizeArray() && type.getElementType().isFloat32());
+    auto numChannels = (uint32_t) type.getElementType().getVectorSize();
+
+    return { static_cast<float*> (interleavedArray.getPackedData()), numChannels, (uint32_t) type.getArraySize(), numChannels };
+}
+
+/** Builds the value for an unsized array or audio-sample struct, using a function that returns
+    a constant table handle for the frame data with a given number of channels.
+    Returns an invalid value if the type is neither of these.
+*/
+template <typename GetArrayHandleFn>
+static Value convertAudioDataToArrayOrStruct (const Type& requestedType, double sampleRate, GetArrayHandleFn&& getArrayHandle)
 {
     if (requestedType.isUnsizedArray())
     {
         auto elementType = requestedType.getElementType();
 
         if ((elementType.isPrimitive() || elementType.isVector()) && elementType.isFloat32())
-            return Value::createUnsizedArray (elementType, constantTable.getHandleForValue (Value::createInterleavedFloatArray ((uint32_t) elementType.getVectorSize(), data)));
+            return Value::createUnsizedArray (elementType, getArrayHandle ((uint32_t) elementType.getVectorSize()));
     }
 
     if (requestedType.isStruct())
@@ -149,7 +169,11 @@ Value convertAudioDataToType (const Type& requestedType, ConstantTable& constant
             }
             else if (m.type.isUnsizedArray())
             {
-                auto dataValue = convertAudioDataToType (m.type, constantTable, data, sampleRate);
+                auto dataValue = convertAudioDataToArrayOrStruct (m.type, sampleRate, getArrayHandle);
+
+                if (! dataValue.isValid())
+                    dataValue = Value::zeroInitialiser (m.type);
+
                 memberValues.push_back (std::move (dataValue));
             }
             else
@@ -161,66 +185,210 @@ Value convertAudioDataToType (const Type& requestedType, ConstantTable& constant
         return Value::createStruct (s, memberValues);
     }
 
-    return Value::createInterleavedFloatArray (data.numChannels, data);
+    return {};
 }
 
-//==============================================================================
-Value generateWaveform (const Type& requiredType, ConstantTable& constantTable,
-                        double frequency, double sampleRate, int64_t numFrames,
-                        WaveGenerators::Generator& generator,
-                        uint32_t oversamplingFactor)
+Value convertAudioDataToType (const Type& requestedType, ConstantTable& constantTable,
+                              DiscreteChannelSet<float> data, double sampleRate)
 {
-    if (numFrames > 0 && frequency > 0 && sampleRate > 0 && numFrames < 48000 * 60 * 60 * 2)
+    return convertAudioDataToType (requestedType, constantTable, data.numChannels, data.numFrames, sampleRate,
+                                   [&] (InterleavedChannelSet<float> dest) { copyChannelSetToFit (dest, data); });
+}
+
+Value convertAudioDataToType (const Type& requestedType, ConstantTable& constantTable,
+                              uint32_t numChannels, uint32_t numFrames, double sampleRate,
+                              const AudioDataFillFn& fillData)
+{
+    auto result = convertAudioDataToArrayOrStruct (requestedType, sampleRate, [&] (uint32_t targetNumChannels)
     {
-        AllocatedChannelSet<DiscreteChannelSet<float>> data (1, (uint32_t) (numFrames * oversamplingFactor));
-        auto* samples = data.channelSet.getChannel (0);
+        return constantTable.getHandleForValue (createInterleavedFloatArray (targetNumChannels, numFrames, fillData));
+    });
 
+    if (result.isValid())
+        return result;
+
+    return createInterleavedFloatArray (numChannels, numFrames, fillData);
+}
+
+Value convertAudioDataToType (const Type& requestedType, ConstantTable& constantTable,
+                              Value interleavedData, double sampleRate)
+{
+    auto source = getInterleavedChannelSet (interleavedData);
+    ConstantTable::Handle sourceHandle = {};
+
+    auto result = convertAudioDataToArrayOrStruct (requestedType, sampleRate, [&] (uint32_t targetNumChannels)
+    {
+        if (targetNumChannels == source.numChannels)
+        {
+            // The data is already in the right layout, so can go straight into the table
+            if (sourceHandle == ConstantTable::Handle())
+            {
+                sourceHandle = constantTable.getHandleForValue (std::move (interleavedData));
+                source = getInterleavedChannelSet (*constantTable.getValueForHandle (sourceHandle));
+            }
+
+            return sourceHandle;
+        }
+
+        return constantTable.getHandleForValue (createInterleavedFloatArray (targetNumChannels, source.numFrames,
+                                                                             [&] (InterleavedChannelSet<float> dest) { copyChannelSetToFit (dest, source); }));
+    });
+
+    if (result.isValid())
+        return result;
+
+    return interleavedData;
+}
+
+//==============================================================================
+namespace WaveGenerators
+{
+    using SampleData = std::shared_ptr<std::vector<float>>;
+
+    /** Renders a waveform, which is oversampled and then resampled down to the final size
+        if the generator needs it.
+        The generator's type is known here, so calls to getSample() don't need to be virtual.
+    */
+    template <class GeneratorType>
+    SampleData generateSamples (double frequency, double sampleRate, uint32_t numFrames, uint32_t oversamplingFactor)
+    {
+        GeneratorType generator;
+        auto samples = std::make_shared<std::vector<float>> ((size_t) numFrames * oversamplingFactor);
         generator.init (frequency, sampleRate * oversamplingFactor);
 
-        for (uint32_t i = 0; i < data.channelSet.numFrames; ++i)
+        for (auto& sample : *samples)
         {
-            samples[i] = (float) generator.getSample();
+            sample = (float) generator.GeneratorType::getSample();
             generator.advance();
         }
 
         if (oversamplingFactor == 1)
-            return convertAudioDataToType (requiredType, constantTable, data.channelSet, sampleRate);
+            return samples;
+
+        auto resampled = std::make_shared<std::vector<float>> ((size_t) numFrames);
+        auto* sourceData = samples->data();
+        auto* destData = resampled->data();
 
-        // Resample to the right size
-        AllocatedChannelSet<DiscreteChannelSet<float>> resampledData (1, (uint32_t) (numFrames));
-        resampleToFit (resampledData.channelSet, data.channelSet);
-        return convertAudioDataToType (requiredType, constantTable, resampledData.channelSet, sampleRate);
+        // 50 zero crossings matches the quality of the resampleToFit() call this replaced
+        fastResampleToFit ({ &destData, 1, 0, numFrames },
+                           { &sourceData, 1, 0, (uint32_t) samples->size() }, nullptr, 50);
+        return resampled;
     }
 
-    return {};
+    //==============================================================================
+    /** A process-wide cache of generated waveforms.
+
+        The same few waveforms tend to be asked for by every instance of a synth, and again
+        each time it's recompiled, so the finished samples are kept and shared, up to a limit
+        on the total size, after which the oldest entries are dropped. Waveforms which are
+        larger than that limit are never kept.
+    */
+    struct Cache
+    {
+        static Cache& getInstance()
+        {
+            static Cache cache;
+            return cache;
+        }
+
+        template <typename CreateFn>
+        SampleData get (const char* shape, double frequency, double sampleRate, uint32_t numFrames, CreateFn&& create)
+        {
+            Key key { shape, frequency, sampleRate, numFrames };
+
+            {
+                std::lock_guard<std::mutex> l (lock);
+
+                for (auto& e : entries)
+                    if (e.key == key)
+                        return e.data;
+            }
+
+            // Generate without holding the lock, so that other threads aren't held up. If two
+            // threads race to create the same waveform, both copies are identical
+            auto data = create();
+            auto dataBytes = data->size() * sizeof (float);
+
+            // A waveform that's bigger than the whole cache is handed back without being kept
+            if (dataBytes > maxTotalBytes)
+                return data;
+
+            std::lock_guard<std::mutex> l (lock);
+            entries.push_back ({ key, data });
+            totalBytes += dataBytes;
+
+            while (totalBytes > maxTotalBytes)
+            {
+                totalBytes -= entries.front().data->size() * sizeof (float);
+                entries.pop_front();
+            }
+
+            return data;
+        }
+
+    private:
+        struct Key
+        {
+            std::string shape;
+            double frequency, sampleRate;
+            uint32_t numFrames;
+
+            bool operator== (const Key& other) const
+            {
+                return shape == other.shape && frequency == other.frequency
+                        && sampleRate == other.sampleRate && numFrames == other.numFrames;
+            }
+        };
+
+        struct Entry
+        {
+            Key key;
+            SampleData data;
+        };
+
+        static constexpr size_t maxTotalBytes = 64 * 1024 * 1024;
+
+        std::mutex lock;
+        std::deque<Entry> entries;
+        size_t totalBytes = 0;
+    };
 }
 
 template <class Generator>
-static Value generateWaveform (const Type& requiredType, ConstantTable& constantTable, const Annotation& annotation, uint32_t oversamplingFactor)
+static Value generateWaveform (const Type& requiredType, ConstantTable& constantTable, const Annotation& annotation,
+                               const char* shape, uint32_t oversamplingFactor)
 {
-    Generator g;
-
-    return generateWaveform (requiredType, constantTable,
-                             annotation.getDouble ("frequency"),
-                             annotation.getDouble ("rate"),
-                             annotation.getInt64 ("numFrames"),
-                             g,
-                             oversamplingFactor);
+    auto frequency  = annotation.getDouble ("frequency");
+    auto sampleRate = annotation.getDouble ("rate");
+    auto numFrames  = annotation.getInt64 ("numFrames");
+
+    if (numFrames > 0 && frequency > 0 && sampleRate > 0 && numFrames < 48000 * 60 * 60 * 2)
+    {
+        auto samples = WaveGenerators::Cache::getInstance().get (shape, frequency, sampleRate, (uint32_t) numFrames, [&]
+        {
+            return WaveGenerators::generateSamples<Generator> (frequency, sampleRate, (uint32_t) numFrames, oversamplingFactor);
+        });
+
+        auto* channel = samples->data();
+        return convertAudioDataToType (requiredType, constantTable, DiscreteChannelSet<float> { &channel, 1, 0, (uint32_t) numFrames }, sampleRate);
+    }
+
+    return {};
 }
 
 Value generateWaveform (const Type& requiredType, ConstantTable& constantTable, const Annotation& annotation)
 {
     if (annotation.getBool ("sinewave") || annotation.getBool ("sine"))
-        return generateWaveform<WaveGenerators::Sine> (requiredType, constantTable, annotation, 1);
+        return generateWaveform<WaveGenerators::Sine> (requiredType, constantTable, annotation, "sine", 1);
 
     if (annotation.getBool ("sawtooth") || annotation.getBool ("saw"))
-        return generateWaveform<WaveGenerators::Saw> (requiredType, constantTable, annotation, 2);
+        return generateWaveform<WaveGenerators::Saw> (requiredType, constantTable, annotation, "saw", 2);
 
     if (annotation.getBool ("triangle"))
-        return generateWaveform<WaveGenerators::Triangle> (requiredType, constantTable, annotation, 2);
+        return generateWaveform<WaveGenerators::Triangle> (requiredType, constantTable, annotation, "triangle", 2);
 
     if (annotation.getBool ("squarewave") || annotation.getBool ("square"))
-        return generateWaveform<WaveGenerators::Square> (requiredType, constantTable, annotation, 2);
+        return generateWaveform<WaveGenerators::Square> (requiredType, constantTable, annotation, "square", 2);
 
     return {};
 }
@@ -28,6 +28,25 @@ namespace soul
 Value convertAudioDataToType (const Type& requestedType, ConstantTable&,
                               DiscreteChannelSet<float> data, double sampleRate);
 
+/** A callback which must fill the given interleaved buffer with audio data. */
+using AudioDataFillFn = std::function<void(InterleavedChannelSet<float> dest)>;
+
+/** Like convertAudioDataToType(), but rather than copying from an existing buffer, this
+    creates the value at its final size and asks a callback to write the data into it.
+    That lets the caller stream the audio in from its source in chunks, rather than
+    holding a complete copy of it in memory.
+*/
+Value convertAudioDataToType (const Type& requestedType, ConstantTable&,
+                              uint32_t numChannels, uint32_t numFrames, double sampleRate,
+                              const AudioDataFillFn& fillData);
+
+/** Like convertAudioDataToType(), but takes data which has already been decoded into a
+    float<numChannels>[numFrames] array. If the requested type uses the same number of
+    channels, the array is moved into the constant table rather than being copied.
+*/
+Value convertAudioDataToType (const Type& requestedType, ConstantTable&,
+                              Value interleavedData, double sampleRate);
+
 /** Builds a suitable type of value from a generated waveform, where the
     generator function takes a phase value 0->1 and returns the amplitude -1 to 1.
 */
@@ -353,6 +353,33 @@ bool isChannelSetAllZero (ChannelSetType channelSet)
     return true;
 }
 
+/** Returns true if no sample in the channel set has a magnitude greater than the threshold. */
+template <typename ChannelSetType, typename SampleType>
+bool isChannelSetSilent (ChannelSetType channelSet, SampleType threshold)
+{
+    static constexpr uint32_t framesPerChunk = 64;
+
+    for (uint32_t chan = 0; chan < channelSet.numChannels; ++chan)
+    {
+        auto data = channelSet.getChannel (chan);
+
+        // The inner loop has no early exit, so that it can be vectorised
+        for (uint32_t start = 0; start < channelSet.numFrames; start += framesPerChunk)
+        {
+            auto end = std::min (start + framesPerChunk, channelSet.numFrames);
+            bool anyAboveThreshold = false;
+
+            for (uint32_t i = start; i < end; ++i)
+                anyAboveThreshold |= std::abs (data[i * channelSet.stride]) > threshold;
+
+            if (anyAboveThreshold)
+                return false;
+        }
+    }
+
+    return true;
+}
+
 template <typename Type1, typename Type2>
 bool channelSetContentIsIdentical (Type1 set1, Type2 set2)
 {
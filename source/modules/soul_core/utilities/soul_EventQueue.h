@@ -21,17 +21,64 @@
 namespace soul
 {
 
+//==============================================================================
+/** A FIFO of time-stamped events which is written by a single producer, and which can
+    be read by any number of EventQueues, each of which keeps its own read position.
+
+    This lets a caller deliver the same incoming events to several endpoints while only
+    converting and writing each event once.
+*/
+template <class EventType>
+struct SharedEventBuffer
+{
+    SharedEventBuffer() : events (bufferLength) {}
+
+    struct Event
+    {
+        uint64_t time;
+        EventType value;
+    };
+
+    void addEvent (uint64_t time, EventType value) noexcept
+    {
+        auto pos = writePos.load (std::memory_order_relaxed);
+        auto& e = events[pos % bufferLength];
+        e.time = time;
+        e.value = value;
+        writePos.store (pos + 1, std::memory_order_release);
+    }
+
+    uint64_t getWritePosition() const noexcept                  { return writePos.load (std::memory_order_acquire); }
+    const Event& getEvent (uint64_t pos) const noexcept         { return events[pos % bufferLength]; }
+
+    static constexpr uint32_t bufferLength = 1024;
+
+private:
+    std::vector<Event> events;
+    std::atomic<uint64_t> writePos { 0 };
+};
+
 //==============================================================================
 /** An atomic FIFO for posting and receiving time-stamped event objects.
+
+    By default each queue has its own buffer, which is filled with enqueueEvent(). Several
+    queues can instead be given the same SharedEventBuffer, in which case they all dispatch
+    whatever is added to it.
 */
 template <class EventType>
 struct EventQueue
 {
+    using SharedBuffer = SharedEventBuffer<EventType>;
+
     EventQueue (InputEndpoint::Ptr stream, EndpointProperties endpointProperties)
-        : inputStream (stream), blockSize (endpointProperties.blockSize)
+        : EventQueue (std::move (stream), endpointProperties, std::make_shared<SharedBuffer>())
+    {
+    }
+
+    EventQueue (InputEndpoint::Ptr stream, EndpointProperties endpointProperties, std::shared_ptr<SharedBuffer> sourceBuffer)
+        : inputStream (stream), buffer (std::move (sourceBuffer)), readPos (buffer->getWritePosition())
     {
         SOUL_ASSERT (isEvent (inputStream->getDetails().kind));
-        queue.resize (queueLength);
 
         inputStream->setEventSource ([this] (uint64_t currentTime, uint32_t blockLength, callbacks::PostNextEvent postEvent)
                                      {
@@ -46,18 +93,9 @@ struct EventQueue
         inputStream.reset();
     }
 
-    struct Event
-    {
-        uint64_t time;
-        EventType value;
-    };
-
     void enqueueEvent (uint32_t offset, EventType value)
     {
-        auto& e = getEvent (writePos);
-        e.time = time + offset;
-        e.value = value;
-        ++writePos;
+        buffer->addEvent (time + offset, value);
     }
 
     void enqueueEvents (uint32_t offset, const EventType* p, uint32_t count)
@@ -71,12 +109,12 @@ struct EventQueue
         auto blockEndTime = currentTime + currentBlockSize;
 
         // Catch the writePos as we want to dispatch any events present up to this point only
-        auto writePosSnapshot = writePos.load();
+        auto writePosSnapshot = buffer->getWritePosition();
 
         // Dispatch any events for this time
         while (readPos < writePosSnapshot)
         {
-            const auto& e = getEvent (readPos);
+            const auto& e = buffer->getEvent (readPos);
 
             if (e.time > currentTime)
                 break;
@@ -87,7 +125,7 @@ struct EventQueue
 
         if (readPos < writePosSnapshot)
         {
-            auto nextEventTime = getEvent (readPos).time;
+            auto nextEventTime = buffer->getEvent (readPos).time;
 
             if (nextEventTime < blockEndTime)
             {
@@ -104,15 +142,10 @@ struct EventQueue
 
     InputEndpoint::Ptr inputStream;
     std::atomic<uint64_t> time { 0 };
-    std::vector<Event> queue;
 
 private:
-    uint32_t blockSize;
-
-    static constexpr uint32_t queueLength = 1024;
-    std::atomic<uint64_t> readPos { 0 }, writePos { 0 };
-
-    Event& getEvent (uint64_t pos) noexcept    { return queue[pos % queueLength]; }
+    std::shared_ptr<SharedBuffer> buffer;
+    std::atomic<uint64_t> readPos { 0 };
 };
 
 }
@@ -108,6 +108,7 @@ struct Identifier  final
 private:
     //==============================================================================
     friend struct Pool;
+    friend struct std::hash<Identifier>;
     const std::string* name = nullptr;
 
     explicit Identifier (const std::string* s) : name (s) {}
@@ -300,3 +301,15 @@ struct IdentifierPath  final
 
 
 } // namespace soul
+
+namespace std
+{
+    /** Identifiers are interned by an Identifier::Pool, so two equal identifiers from the
+        same pool always share the same string object, and its address makes a good hash.
+    */
+    template <>
+    struct hash<soul::Identifier>
+    {
+        size_t operator() (const soul::Identifier& i) const noexcept { return reinterpret_cast<size_t> (i.name); }
+    };
+}
@@ -170,12 +170,46 @@ public:
         auto address = prepareSpaceForObject (sizeof (Type));
         auto newObject = new (address) Type (std::forward<Args> (args)...);
         currentPool->registerNewObject (sizeof (Type), [] (void* t) { static_cast<Type*> (t)->~Type(); });
+
+        if (numStatisticsUsers.load (std::memory_order_relaxed) != 0)
+        {
+            auto& stats = getThreadStatistics();
+            ++stats.numObjects;
+            stats.numBytes += sizeof (Type);
+        }
+
         return *newObject;
     }
 
+    /** Running totals of the objects that all pools have allocated on a thread. */
+    struct Statistics
+    {
+        uint64_t numObjects = 0, numBytes = 0;
+    };
+
+    /** Returns the totals for the calling thread. These only ever increase, so to measure
+        some work, take the difference between the values before and after it.
+        Allocations are only counted while something has called startCountingAllocations(),
+        so that normal compiles don't pay for a thread-local lookup on every allocation.
+    */
+    static Statistics& getThreadStatistics() noexcept
+    {
+        static thread_local Statistics stats;
+        return stats;
+    }
+
+    /** Turns on the counting of allocations in every thread's Statistics. Each call must
+        be matched by a call to stopCountingAllocations(). CompileProfiler does this while
+        it's active.
+    */
+    static void startCountingAllocations() noexcept     { ++numStatisticsUsers; }
+    static void stopCountingAllocations() noexcept      { --numStatisticsUsers; }
+
 private:
     using DestructorFn = void(void*);
 
+    static inline std::atomic<uint32_t> numStatisticsUsers { 0 };
+
     struct PoolItem
     {
         size_t size;
@@ -0,0 +1,286 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#if ! SOUL_INSIDE_CORE_CPP
+ #error "Don't add this cpp file to your build, it gets included indirectly by soul_core.cpp"
+#endif
+
+namespace soul
+{
+
+static double getResamplerWindowedSinc (double f, double numZeroCrossings) noexcept
+{
+    if (f == 0)
+        return 1.0;
+
+    if (f > numZeroCrossings || f < -numZeroCrossings)
+        return 0;
+
+    f *= pi;
+    auto window = 0.5 + 0.5 * std::cos (f / numZeroCrossings);
+    return window * std::sin (f) / f;
+}
+
+//==============================================================================
+ResamplerKernelTable::ResamplerKernelTable (double sourceFramesPerDestFrame, uint32_t zeroCrossings, uint32_t phases)
+    : numPhases (phases)
+{
+    SOUL_ASSERT (sourceFramesPerDestFrame > 0 && zeroCrossings > 0 && numPhases > 0);
+
+    auto cutoff = std::min (1.0, 1.0 / sourceFramesPerDestFrame);
+    halfLength = (uint32_t) std::ceil (zeroCrossings / cutoff);
+    kernelSize = getAlignedSize<4> (halfLength * 2);
+    kernels.resize ((numPhases + 1) * kernelSize);
+
+    std::vector<double> kernel (kernelSize);
+
+    // The extra phase at the end is a copy of the first one shifted by a tap, so that
+    // the interpolation between adjacent phases never needs to wrap around
+    for (uint32_t phase = 0; phase <= numPhases; ++phase)
+    {
+        auto fraction = phase / (double) numPhases;
+        double total = 0;
+
+        for (uint32_t i = 0; i < kernelSize; ++i)
+        {
+            auto distance = fraction + (double) getNumTapsBeforePosition() - (double) i;
+            kernel[i] = getResamplerWindowedSinc (cutoff * distance, (double) zeroCrossings);
+            total += kernel[i];
+        }
+
+        // normalising each phase to unity gain avoids any DC ripple from the interpolation
+        auto dest = kernels.data() + phase * kernelSize;
+
+        for (uint32_t i = 0; i < kernelSize; ++i)
+            dest[i] = static_cast<float> (kernel[i] / total);
+    }
+}
+
+float ResamplerKernelTable::getInterpolatedSample (const float* samples, uint32_t phase, float alpha) const noexcept
+{
+    SOUL_ASSERT (phase < numPhases);
+    auto kernel1 = kernels.data() + phase * kernelSize;
+    auto kernel2 = kernel1 + kernelSize;
+
+   #if SOUL_INTEL
+    auto sum1 = _mm_setzero_ps();
+    auto sum2 = _mm_setzero_ps();
+
+    for (uint32_t i = 0; i < kernelSize; i += 4)
+    {
+        auto s = _mm_loadu_ps (samples + i);
+        sum1 = _mm_add_ps (sum1, _mm_mul_ps (s, _mm_loadu_ps (kernel1 + i)));
+        sum2 = _mm_add_ps (sum2, _mm_mul_ps (s, _mm_loadu_ps (kernel2 + i)));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps (lanes, _mm_add_ps (sum1, _mm_mul_ps (_mm_set1_ps (alpha), _mm_sub_ps (sum2, sum1))));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   #else
+    float sum1 = 0, sum2 = 0;
+
+    for (uint32_t i = 0; i < kernelSize; ++i)
+    {
+        sum1 += samples[i] * kernel1[i];
+        sum2 += samples[i] * kernel2[i];
+    }
+
+    return sum1 + alpha * (sum2 - sum1);
+   #endif
+}
+
+//==============================================================================
+void fastResampleToFit (DiscreteChannelSet<float> dest, DiscreteChannelSet<const float> source,
+                        ThreadPool* threadPool, uint32_t zeroCrossings)
+{
+    SOUL_ASSERT (dest.numChannels == source.numChannels);
+
+    if (dest.numFrames == source.numFrames)
+        return copyChannelSet (dest, source);
+
+    if (source.numFrames == 0)
+        return dest.clear();
+
+    static constexpr uint32_t numPhases = 512;
+    static constexpr uint32_t framesPerChunk = 16384;
+
+    auto sampleIncrement = double (source.numFrames) / double (dest.numFrames);
+    ResamplerKernelTable table (sampleIncrement, zeroCrossings, numPhases);
+
+    auto numChunksPerChannel = (dest.numFrames + framesPerChunk - 1) / framesPerChunk;
+    auto numChunks = numChunksPerChannel * dest.numChannels;
+
+    auto resampleChunk = [&] (size_t chunk)
+    {
+        auto channel    = (uint32_t) (chunk / numChunksPerChannel);
+        auto startFrame = (uint32_t) (chunk % numChunksPerChannel) * framesPerChunk;
+        auto endFrame   = std::min (dest.numFrames, startFrame + framesPerChunk);
+
+        auto src = source.getChannel (channel);
+        auto dst = dest.getChannel (channel);
+        auto numSourceFrames = (int64_t) source.numFrames;
+        auto kernelSize = (int64_t) table.kernelSize;
+        auto tapsBefore = (int64_t) table.getNumTapsBeforePosition();
+
+        std::vector<float> edgeSamples ((size_t) kernelSize);
+
+        for (auto i = startFrame; i < endFrame; ++i)
+        {
+            auto position = sampleIncrement * i;
+            auto intPos = (int64_t) position;
+            auto phasePosition = (position - (double) intPos) * numPhases;
+            auto phase = std::min (numPhases - 1, (uint32_t) phasePosition);
+            auto alpha = (float) (phasePosition - phase);
+            auto firstTap = intPos - tapsBefore;
+
+            if (firstTap >= 0 && firstTap + kernelSize <= numSourceFrames)
+            {
+                dst[i] = table.getInterpolatedSample (src + firstTap, phase, alpha);
+            }
+            else
+            {
+                for (int64_t j = 0; j < kernelSize; ++j)
+                {
+                    auto index = firstTap + j;
+                    edgeSamples[(size_t) j] = (index >= 0 && index < numSourceFrames) ? src[index] : 0.0f;
+                }
+
+                dst[i] = table.getInterpolatedSample (edgeSamples.data(), phase, alpha);
+            }
+        }
+    };
+
+    if (threadPool != nullptr)
+        return threadPool->parallelFor (numChunks, resampleChunk);
+
+    for (size_t i = 0; i < numChunks; ++i)
+        resampleChunk (i);
+}
+
+//==============================================================================
+StreamingResampler::StreamingResampler (uint32_t channels, double sourceRate, double destRate, uint32_t zeroCrossings)
+    : numChannels (channels),
+      step (getFixedPointStep (sourceRate, destRate)),
+      kernel (sourceRate / destRate, zeroCrossings, numPhases)
+{
+    SOUL_ASSERT (sourceRate > 0 && destRate > 0);
+    history.resize ((size_t) numChannels * kernel.kernelSize * 2);
+    reset();
+}
+
+void StreamingResampler::reset()
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    historyPos = 0;
+    timeToNextOutput = fixedPointOne;
+}
+
+uint32_t StreamingResampler::getNumDestFramesProduced (uint32_t numSourceFrames) const
+{
+    auto endTime = (numSourceFrames + 1ull) * fixedPointOne;
+
+    if (timeToNextOutput >= endTime)
+        return 0;
+
+    return (uint32_t) ((endTime - timeToNextOutput - 1) / step + 1);
+}
+
+uint32_t StreamingResampler::getNumSourceFramesNeeded (uint32_t numDestFrames) const
+{
+    if (numDestFrames == 0)
+        return 0;
+
+    return (uint32_t) ((timeToNextOutput + (numDestFrames - 1) * step) >> 32);
+}
+
+uint32_t StreamingResampler::getMaxSourceFramesNeeded (uint32_t numDestFrames) const
+{
+    return getMaxSourceFramesNeeded (numDestFrames, step);
+}
+
+uint32_t StreamingResampler::getMaxSourceFramesNeeded (uint32_t numDestFrames, double sourceRate, double destRate)
+{
+    return getMaxSourceFramesNeeded (numDestFrames, getFixedPointStep (sourceRate, destRate));
+}
+
+uint32_t StreamingResampler::getMaxSourceFramesNeeded (uint32_t numDestFrames, uint64_t step)
+{
+    if (numDestFrames == 0)
+        return 0;
+
+    return (uint32_t) ((fixedPointOne + numDestFrames * step - 1) >> 32);
+}
+
+uint64_t StreamingResampler::getFixedPointStep (double sourceRate, double destRate)
+{
+    return (uint64_t) ((sourceRate / destRate) * (double) fixedPointOne + 0.5);
+}
+
+void StreamingResampler::process (DiscreteChannelSet<const float> source, DiscreteChannelSet<float> dest)
+{
+    SOUL_ASSERT (numChannels == 0 || (source.numChannels == numChannels && dest.numChannels == numChannels));
+    SOUL_ASSERT (dest.numFrames <= getNumDestFramesProduced (source.numFrames));
+    uint32_t numDone = 0;
+
+    auto writeOutputFrames = [&]
+    {
+        while (timeToNextOutput < fixedPointOne && numDone < dest.numFrames)
+        {
+            for (uint32_t chan = 0; chan < numChannels; ++chan)
+                dest.getChannel (chan)[numDone] = getNextOutputSample (chan);
+
+            ++numDone;
+            timeToNextOutput += step;
+        }
+    };
+
+    // any frames left over from the last call are due before the next source frame
+    writeOutputFrames();
+
+    for (uint32_t i = 0; i < source.numFrames; ++i)
+    {
+        SOUL_ASSERT (timeToNextOutput >= fixedPointOne);
+
+        for (uint32_t chan = 0; chan < numChannels; ++chan)
+        {
+            auto h = history.data() + chan * kernel.kernelSize * 2;
+            h[historyPos] = h[historyPos + kernel.kernelSize] = source.getChannel (chan)[i];
+        }
+
+        if (++historyPos == kernel.kernelSize)
+            historyPos = 0;
+
+        timeToNextOutput -= fixedPointOne;
+        writeOutputFrames();
+    }
+
+    SOUL_ASSERT (numDone == dest.numFrames);
+}
+
+float StreamingResampler::getNextOutputSample (uint32_t channel) const noexcept
+{
+    auto fraction = (uint32_t) timeToNextOutput;
+    auto alpha = (float) (fraction & phaseFractionMask) * (1.0f / (float) (1u << phaseShift));
+    auto samples = history.data() + channel * kernel.kernelSize * 2 + historyPos;
+
+    return kernel.getInterpolatedSample (samples, fraction >> phaseShift, alpha);
+}
+
+}
@@ -106,4 +106,117 @@ void resampleToFit (DestType dest, SourceType source, int zeroCrossings = 50)
         Resampler::resample (dest.getChannelSet (channel, 1), source.getChannelSet (channel, 1), zeroCrossings);
 }
 
+//==============================================================================
+/**
+    A table of windowed-sinc kernels for a particular conversion ratio, evaluated at a
+    fixed number of fractional positions between samples.
+
+    Each kernel is kernelSize taps long, and is applied to the block of samples which
+    starts getNumTapsBeforePosition() frames before the integer part of the position
+    being interpolated. The kernels are normalised to unity gain, and when down-sampling
+    they are widened so that they also act as an anti-aliasing filter.
+*/
+struct ResamplerKernelTable
+{
+    ResamplerKernelTable (double sourceFramesPerDestFrame, uint32_t zeroCrossings, uint32_t numPhases);
+
+    /** Returns the filtered value at the given phase, where samples points to the first of
+        kernelSize contiguous source samples, and the alpha value is the position between
+        this phase and the next one.
+    */
+    float getInterpolatedSample (const float* samples, uint32_t phase, float alpha) const noexcept;
+
+    uint32_t getNumTapsBeforePosition() const noexcept      { return kernelSize - halfLength - 1; }
+
+    uint32_t numPhases = 0, kernelSize = 0, halfLength = 0;
+    std::vector<float> kernels;
+};
+
+//==============================================================================
+/**
+    A faster alternative to resampleToFit(), which uses a precomputed ResamplerKernelTable
+    rather than evaluating the sinc function for every tap, and which can split the work
+    into chunks to be run across a ThreadPool if one is supplied.
+*/
+void fastResampleToFit (DiscreteChannelSet<float> dest, DiscreteChannelSet<const float> source,
+                        ThreadPool* threadPool = nullptr, uint32_t zeroCrossings = 32);
+
+//==============================================================================
+/**
+    A streaming polyphase windowed-sinc resampler, which converts a continuous stream
+    of audio from one sample rate to another, carrying its state across successive
+    blocks of data.
+
+    The filter kernel is evaluated once, when the object is created, into a
+    ResamplerKernelTable, so the per-sample cost is just an interpolated dot-product with
+    the history buffer. Time is tracked in fixed-point so that the number of frames
+    produced for a given number of input frames can be predicted exactly by the caller.
+*/
+class StreamingResampler
+{
+public:
+    StreamingResampler (uint32_t numChannels, double sourceRate, double destRate,
+                        uint32_t zeroCrossings = 16);
+
+    /** Clears the history and restarts the timing. */
+    void reset();
+
+    uint32_t getNumChannels() const                 { return numChannels; }
+
+    /** Returns the number of source frames that each output frame advances by. */
+    double getSourceFramesPerDestFrame() const      { return (double) step / (double) fixedPointOne; }
+
+    /** Returns the number of frames that the process() method will produce if given
+        this many source frames in its current state.
+    */
+    uint32_t getNumDestFramesProduced (uint32_t numSourceFrames) const;
+
+    /** Returns the smallest number of source frames that must be passed to process()
+        for it to produce at least the given number of output frames.
+    */
+    uint32_t getNumSourceFramesNeeded (uint32_t numDestFrames) const;
+
+    /** Returns the largest number of source frames that getNumSourceFramesNeeded() could
+        return for the given number of output frames, whatever the current state is.
+    */
+    uint32_t getMaxSourceFramesNeeded (uint32_t numDestFrames) const;
+
+    /** Returns the value that getMaxSourceFramesNeeded() would return for a resampler
+        with these rates, without needing to create one.
+    */
+    static uint32_t getMaxSourceFramesNeeded (uint32_t numDestFrames, double sourceRate, double destRate);
+
+    /** Returns the delay which the filter introduces, as a number of source frames. */
+    uint32_t getLatencyInSourceFrames() const       { return kernel.halfLength; }
+
+    /** Consumes all the source frames, and writes the resulting frames into the destination.
+        The destination can have up to getNumDestFramesProduced (source.numFrames) frames.
+        It may only be shorter than that if the frames it omits are all due after the last
+        source frame, which will be the case if the source length was obtained by calling
+        getNumSourceFramesNeeded(). Any omitted frames will be the first ones written by
+        the next call.
+        If the resampler has no channels, this just advances the timing.
+    */
+    void process (DiscreteChannelSet<const float> source, DiscreteChannelSet<float> dest);
+
+private:
+    static constexpr uint32_t numPhasesLog2 = 8;
+    static constexpr uint32_t numPhases = 1u << numPhasesLog2;
+    static constexpr uint64_t fixedPointOne = 1ull << 32;
+    static constexpr uint32_t phaseShift = 32 - numPhasesLog2;
+    static constexpr uint32_t phaseFractionMask = (1u << phaseShift) - 1;
+
+    const uint32_t numChannels;
+    const uint64_t step;
+    const ResamplerKernelTable kernel;
+    uint32_t historyPos = 0;
+    uint64_t timeToNextOutput = 0;
+    std::vector<float> history;
+
+    float getNextOutputSample (uint32_t channel) const noexcept;
+
+    static uint64_t getFixedPointStep (double sourceRate, double destRate);
+    static uint32_t getMaxSourceFramesNeeded (uint32_t numDestFrames, uint64_t step);
+};
+
 }
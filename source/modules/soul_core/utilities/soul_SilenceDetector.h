@@ -0,0 +1,82 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+namespace soul
+{
+
+//==============================================================================
+/**
+    Decides when something which renders audio in blocks (a processor instance or
+    a whole performer) can be suspended, because its input and output have both been
+    silent for a number of consecutive blocks, with no incoming events.
+
+    Call shouldRenderBlock() before each block. If it returns false, the block can
+    be skipped and its output cleared. Otherwise, render it and pass the result to
+    blockRendered(). Any event or non-silent input wakes it up again straight away.
+*/
+struct SilenceDetector
+{
+    SilenceDetector() = default;
+
+    /** A number of blocks of 0 disables suspension. */
+    SilenceDetector (uint32_t numSilentBlocksBeforeSuspending, float silenceThreshold)
+        : numBlocksNeeded (numSilentBlocksBeforeSuspending), threshold (silenceThreshold)
+    {
+    }
+
+    bool isEnabled() const noexcept         { return numBlocksNeeded != 0; }
+    bool isSuspended() const noexcept       { return isEnabled() && numSilentBlocks >= numBlocksNeeded; }
+
+    /** Restarts the count of silent blocks. */
+    void wakeUp() noexcept                  { numSilentBlocks = 0; inputWasSilent = false; }
+
+    template <typename InputChannelSetType>
+    bool shouldRenderBlock (InputChannelSetType input, bool hasIncomingEvents)
+    {
+        if (! isEnabled())
+            return true;
+
+        inputWasSilent = ! hasIncomingEvents && isChannelSetSilent (input, threshold);
+
+        if (! inputWasSilent)
+            numSilentBlocks = 0;
+
+        return ! isSuspended();
+    }
+
+    template <typename OutputChannelSetType>
+    void blockRendered (OutputChannelSetType output)
+    {
+        if (isEnabled())
+        {
+            if (inputWasSilent && isChannelSetSilent (output, threshold))
+                ++numSilentBlocks;
+            else
+                numSilentBlocks = 0;
+        }
+    }
+
+private:
+    uint32_t numBlocksNeeded = 0, numSilentBlocks = 0;
+    float threshold = 0;
+    bool inputWasSilent = false;
+};
+
+}
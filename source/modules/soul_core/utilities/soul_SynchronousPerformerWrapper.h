@@ -25,6 +25,10 @@ namespace soul
 /**
     Wraps up the endpoints of a Performer so that it can be rendered using a single
     synchronous call to provide all the audio and MIDI i/o.
+
+    The performer can optionally be run at a different sample rate to the caller, in
+    which case the audio i/o is passed through a pair of StreamingResamplers, and the
+    number of frames the performer renders per block will vary accordingly.
 */
 struct SynchronousPerformerWrapper
 {
@@ -37,7 +41,12 @@ struct SynchronousPerformerWrapper
         detach();
     }
 
-    void attach (EndpointProperties properties)
+    /** Connects to the performer's endpoints.
+        The properties should describe the rate and maximum block size at which the performer
+        itself will run. If a host sample rate is supplied and differs from this, all audio
+        will be resampled between the two rates.
+    */
+    void attach (EndpointProperties properties, double hostSampleRate = 0)
     {
         detach();
 
@@ -53,7 +62,12 @@ struct SynchronousPerformerWrapper
             }
 
             if (isMIDIEventInput (*i))
-                midiEventQueues.push_back (std::make_unique<MidiEventQueueType> (i, properties));
+            {
+                if (incomingMIDI == nullptr)
+                    incomingMIDI = std::make_shared<MidiEventQueueType::SharedBuffer>();
+
+                midiEventQueues.push_back (std::make_unique<MidiEventQueueType> (i, properties, incomingMIDI));
+            }
         }
 
         for (auto& o : performer.getOutputEndpoints())
@@ -64,6 +78,10 @@ struct SynchronousPerformerWrapper
                 totalNumOutputChannels += numChans;
             }
         }
+
+        if (hostSampleRate > 0 && hostSampleRate != properties.sampleRate)
+            rateConverter = std::make_unique<RateConverter> (totalNumInputChannels, totalNumOutputChannels,
+                                                             hostSampleRate, properties.sampleRate, properties.blockSize);
     }
 
     void detach()
@@ -71,10 +89,59 @@ struct SynchronousPerformerWrapper
         sources.clear();
         sinks.clear();
         midiEventQueues.clear();
+        incomingMIDI.reset();
+        rateConverter.reset();
         totalNumInputChannels = 0;
         totalNumOutputChannels = 0;
     }
 
+    /** Clears any audio that is being held in the rate conversion buffers.
+        Note that this doesn't reset the performer itself.
+    */
+    void reset()
+    {
+        if (rateConverter != nullptr)
+            rateConverter->reset();
+
+        silenceDetector.wakeUp();
+    }
+
+    /** If the number of blocks is more than 0, the performer will stop being run once its audio
+        input and output have been silent, with no incoming MIDI, for that many blocks in a row.
+        It starts again as soon as there's some MIDI or non-silent input, or wakeUp() is called.
+    */
+    void setSuspendWhenSilent (uint32_t numSilentBlocks, float silenceThreshold = 1.0e-5f)
+    {
+        silenceDetector = SilenceDetector (numSilentBlocks, silenceThreshold);
+    }
+
+    /** Restarts a performer which was suspended because of silence, e.g. because some
+        input that the wrapper doesn't know about has changed.
+    */
+    void wakeUp()
+    {
+        silenceDetector.wakeUp();
+    }
+
+    /** Returns the largest number of frames that the performer may be asked to render when
+        the host calls render() with the given number of frames.
+    */
+    static uint32_t getMaxPerformerBlockSize (uint32_t maxHostBlockSize, double hostSampleRate, double performerSampleRate)
+    {
+        if (hostSampleRate <= 0 || hostSampleRate == performerSampleRate)
+            return maxHostBlockSize;
+
+        return StreamingResampler::getMaxSourceFramesNeeded (maxHostBlockSize, performerSampleRate, hostSampleRate);
+    }
+
+    /** Returns the number of frames (at the host's rate) by which the resampling delays the
+        output, or 0 if the performer runs at the host's rate.
+    */
+    uint32_t getLatencyInFrames() const
+    {
+        return rateConverter != nullptr ? rateConverter->getLatencyInHostFrames() : 0;
+    }
+
     template <typename MIDIEventType>
     void render (DiscreteChannelSet<const float> input,
                  DiscreteChannelSet<float> output,
@@ -83,10 +150,84 @@ struct SynchronousPerformerWrapper
     {
         SOUL_ASSERT (input.numFrames == output.numFrames);
 
+        if (! silenceDetector.shouldRenderBlock (input, midiStart != midiEnd))
+            return output.clear();
+
+        renderBlock (input, output, midiStart, midiEnd);
+        silenceDetector.blockRendered (output);
+    }
+
+    uint32_t getExpectedNumInputChannels() const     { return totalNumInputChannels; }
+    uint32_t getExpectedNumOutputChannels() const    { return totalNumOutputChannels; }
+
+private:
+    template <typename MIDIEventType>
+    void renderBlock (DiscreteChannelSet<const float> input,
+                      DiscreteChannelSet<float> output,
+                      const MIDIEventType* midiStart,
+                      const MIDIEventType* midiEnd)
+    {
+        if (rateConverter == nullptr)
+        {
+            addIncomingMIDI (midiStart, midiEnd, 1, 1);
+            return advance (input, output);
+        }
+
+        // The conversion buffers are sized for the largest block that the performer was
+        // linked for, so a longer host block is rendered in several chunks
+        for (uint32_t chunkStart = 0; chunkStart < output.numFrames;)
+        {
+            auto numHostFrames = std::min (output.numFrames - chunkStart, rateConverter->maxHostFramesPerChunk);
+            auto chunkEnd = chunkStart + numHostFrames;
+            auto chunkMIDIEnd = midiStart;
+
+            if (chunkEnd == output.numFrames)
+                chunkMIDIEnd = midiEnd;
+            else
+                while (chunkMIDIEnd != midiEnd && getFrameIndex (*chunkMIDIEnd) < chunkEnd)
+                    ++chunkMIDIEnd;
+
+            auto numPerformerFrames = rateConverter->getNumPerformerFramesNeeded (numHostFrames);
+            addIncomingMIDI (midiStart, chunkMIDIEnd, numPerformerFrames, numHostFrames, chunkStart);
+
+            auto performerOutput = rateConverter->getPerformerOutputBuffer (numPerformerFrames);
+            advance (rateConverter->convertInput (input.getSlice (chunkStart, numHostFrames), numPerformerFrames), performerOutput);
+            rateConverter->convertOutput (performerOutput, output.getSlice (chunkStart, numHostFrames));
+
+            midiStart = chunkMIDIEnd;
+            chunkStart = chunkEnd;
+        }
+    }
+
+    /** Converts the block's MIDI into packed events once, and adds them to the buffer that
+        all the MIDI input queues read from.
+    */
+    template <typename MIDIEventType>
+    void addIncomingMIDI (const MIDIEventType* midiStart, const MIDIEventType* midiEnd,
+                          uint32_t performerFrames, uint32_t hostFrames, uint32_t firstHostFrame = 0)
+    {
+        if (midiStart == midiEnd || incomingMIDI == nullptr)
+            return;
+
+        // The queues all follow the same performer, but one that has never been called back
+        // may lag behind, so the latest time is the one to use
+        uint64_t blockStartTime = 0;
+
         for (auto& queue : midiEventQueues)
-            for (auto midi = midiStart; midi != midiEnd; ++midi)
-                queue->enqueueEvent (getFrameIndex (*midi), (int) getPackedMIDIEvent (*midi));
+            blockStartTime = std::max (blockStartTime, queue->time.load());
+
+        for (auto midi = midiStart; midi != midiEnd; ++midi)
+        {
+            auto hostFrame = (uint64_t) std::max (firstHostFrame, (uint32_t) getFrameIndex (*midi)) - firstHostFrame;
+            auto frame = performerFrames == hostFrames ? hostFrame
+                                                       : (hostFrames == 0 ? 0 : hostFrame * performerFrames / hostFrames);
 
+            incomingMIDI->addEvent (blockStartTime + frame, (int32_t) getPackedMIDIEvent (*midi));
+        }
+    }
+
+    void advance (DiscreteChannelSet<const float> input, DiscreteChannelSet<float> output)
+    {
         if (input.numChannels != 0)
             for (auto& s : sources)
                 s->prepareBuffer (input);
@@ -97,10 +238,150 @@ struct SynchronousPerformerWrapper
         performer.advance (output.numFrames);
     }
 
-    uint32_t getExpectedNumInputChannels() const     { return totalNumInputChannels; }
-    uint32_t getExpectedNumOutputChannels() const    { return totalNumOutputChannels; }
+    //==============================================================================
+    /** Converts the host's audio to and from the rate at which the performer is running.
+        Because the number of performer frames per host block can vary when the ratio isn't
+        an integer, the input side keeps a small FIFO of converted frames.
+    */
+    struct RateConverter
+    {
+        RateConverter (uint32_t numInputChannels, uint32_t numOutputChannels,
+                       double hostRate, double performerRate, uint32_t maxPerformerBlockSize)
+            : inputResampler (numInputChannels, hostRate, performerRate),
+              outputResampler (numOutputChannels, performerRate, hostRate),
+              inputBuffer (numInputChannels, maxPerformerBlockSize + getInputFIFOSlack (hostRate, performerRate)),
+              outputBuffer (numOutputChannels, maxPerformerBlockSize),
+              latencyInHostFrames (getLatency (hostRate, performerRate, numInputChannels != 0))
+        {
+            maxHostFramesPerChunk = std::max (1u, (uint32_t) (maxPerformerBlockSize * hostRate / performerRate));
 
-private:
+            while (maxHostFramesPerChunk > 1 && outputResampler.getMaxSourceFramesNeeded (maxHostFramesPerChunk) > maxPerformerBlockSize)
+                --maxHostFramesPerChunk;
+
+            reset();
+        }
+
+        void reset()
+        {
+            inputResampler.reset();
+            outputResampler.reset();
+
+            // Starting with a couple of frames of silence in the FIFO means that the jitter in the
+            // number of frames produced per block can't cause it to run dry
+            inputBuffer.channelSet.getSlice (0, initialInputLatency).clear();
+            numBufferedInputFrames = initialInputLatency;
+            numConsumedInputFrames = 0;
+        }
+
+        uint32_t getNumPerformerFramesNeeded (uint32_t numHostFrames) const
+        {
+            auto numFrames = outputResampler.getNumSourceFramesNeeded (numHostFrames);
+            SOUL_ASSERT (numFrames <= outputBuffer.channelSet.numFrames);
+            return numFrames;
+        }
+
+        DiscreteChannelSet<const float> convertInput (DiscreteChannelSet<const float> hostInput, uint32_t numPerformerFrames)
+        {
+            auto& buffer = inputBuffer.channelSet;
+
+            if (buffer.numChannels == 0 || hostInput.numChannels == 0)
+                return { buffer.channels, 0, 0, numPerformerFrames };
+
+            discardInputFrames (numConsumedInputFrames);
+
+            auto numNewFrames = inputResampler.getNumDestFramesProduced (hostInput.numFrames);
+
+            // The FIFO has enough slack for any block of up to maxHostFramesPerChunk frames, so
+            // this shouldn't happen, but if it does, the oldest frames are dropped rather than
+            // letting the resampler write past the end of the buffer
+            if (numNewFrames > buffer.numFrames)
+            {
+                SOUL_ASSERT_FALSE;
+                inputResampler.reset();
+                buffer.getSlice (0, numPerformerFrames).clear();
+                numBufferedInputFrames = numConsumedInputFrames = numPerformerFrames;
+                return { buffer.channels, buffer.numChannels, 0, numPerformerFrames };
+            }
+
+            if (numBufferedInputFrames + numNewFrames > buffer.numFrames)
+                discardInputFrames (numBufferedInputFrames + numNewFrames - buffer.numFrames);
+
+            inputResampler.process (hostInput, buffer.getSlice (numBufferedInputFrames, numNewFrames));
+            numBufferedInputFrames += numNewFrames;
+
+            if (numBufferedInputFrames < numPerformerFrames)
+            {
+                buffer.getSlice (numBufferedInputFrames, numPerformerFrames - numBufferedInputFrames).clear();
+                numBufferedInputFrames = numPerformerFrames;
+            }
+
+            numConsumedInputFrames = numPerformerFrames;
+            return { buffer.channels, buffer.numChannels, 0, numPerformerFrames };
+        }
+
+        DiscreteChannelSet<float> getPerformerOutputBuffer (uint32_t numPerformerFrames) const
+        {
+            return outputBuffer.channelSet.getSlice (0, numPerformerFrames);
+        }
+
+        void convertOutput (DiscreteChannelSet<float> performerOutput, DiscreteChannelSet<float> hostOutput)
+        {
+            outputResampler.process ({ performerOutput.channels, performerOutput.numChannels,
+                                       performerOutput.offset, performerOutput.numFrames },
+                                     hostOutput.getChannelSet (0, performerOutput.numChannels));
+        }
+
+        uint32_t getLatencyInHostFrames() const     { return latencyInHostFrames; }
+
+        /** The largest number of host frames which can be converted in one go. */
+        uint32_t maxHostFramesPerChunk = 1;
+
+    private:
+        StreamingResampler inputResampler, outputResampler;
+        AllocatedChannelSet<DiscreteChannelSet<float>> inputBuffer, outputBuffer;
+        uint32_t numBufferedInputFrames = 0, numConsumedInputFrames = 0;
+        const uint32_t latencyInHostFrames;
+
+        static constexpr uint32_t initialInputLatency = 2;
+
+        static uint32_t getInputFIFOSlack (double hostRate, double performerRate)
+        {
+            return 2 * (uint32_t) std::ceil (performerRate / hostRate) + initialInputLatency + 4;
+        }
+
+        /** The output is delayed by the output filter, and if there are any audio inputs, they
+            are also delayed by the input filter and the frames of silence that the FIFO starts with.
+            MIDI doesn't go through either of those, so for a patch with no audio inputs, only the
+            output filter matters.
+        */
+        uint32_t getLatency (double hostRate, double performerRate, bool hasAudioInputs) const
+        {
+            auto performerFramesPerHostFrame = performerRate / hostRate;
+            double latency = outputResampler.getLatencyInSourceFrames() / performerFramesPerHostFrame;
+
+            if (hasAudioInputs)
+                latency += inputResampler.getLatencyInSourceFrames() + initialInputLatency / performerFramesPerHostFrame;
+
+            return (uint32_t) std::lround (latency);
+        }
+
+        void discardInputFrames (uint32_t numToDiscard)
+        {
+            auto& buffer = inputBuffer.channelSet;
+            numToDiscard = std::min (numToDiscard, numBufferedInputFrames);
+            auto numRemaining = numBufferedInputFrames - numToDiscard;
+
+            if (numToDiscard != 0 && numRemaining != 0)
+                for (uint32_t chan = 0; chan < buffer.numChannels; ++chan)
+                    std::memmove (buffer.getChannel (chan), buffer.getChannel (chan) + numToDiscard,
+                                  numRemaining * sizeof (float));
+
+            numBufferedInputFrames = numRemaining;
+            numConsumedInputFrames = 0;
+        }
+    };
+
+    //==============================================================================
     struct InputBufferSliceSource
     {
         InputBufferSliceSource (InputEndpoint& inputToAttachTo,
@@ -242,12 +523,16 @@ private:
 
     //==============================================================================
     Performer& performer;
+    SilenceDetector silenceDetector;
 
     std::vector<std::unique_ptr<InputBufferSliceSource>> sources;
     std::vector<std::unique_ptr<OutputBufferSliceSink>> sinks;
 
     using MidiEventQueueType = EventQueue<int32_t>;
     std::vector<std::unique_ptr<MidiEventQueueType>> midiEventQueues;
+    std::shared_ptr<MidiEventQueueType::SharedBuffer> incomingMIDI;
+
+    std::unique_ptr<RateConverter> rateConverter;
 
     uint32_t totalNumInputChannels = 0, totalNumOutputChannels = 0;
 };
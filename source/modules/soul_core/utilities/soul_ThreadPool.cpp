@@ -0,0 +1,155 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#if ! SOUL_INSIDE_CORE_CPP
+ #error "Don't add this cpp file to your build, it gets included indirectly by soul_core.cpp"
+#endif
+
+namespace soul
+{
+
+ThreadPool::ThreadPool (uint32_t numThreads)
+{
+    if (numThreads == 0)
+        numThreads = std::max (1u, std::thread::hardware_concurrency());
+
+    threads.reserve (numThreads);
+
+    for (uint32_t i = 0; i < numThreads; ++i)
+        threads.emplace_back ([this] { runWorker(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> l (lock);
+        shouldExit = true;
+        jobs.clear();
+    }
+
+    jobAdded.notify_all();
+
+    for (auto& t : threads)
+        t.join();
+}
+
+void ThreadPool::addJob (Job job)
+{
+    SOUL_ASSERT (job != nullptr);
+
+    {
+        std::lock_guard<std::mutex> l (lock);
+        jobs.push_back (std::move (job));
+    }
+
+    jobAdded.notify_one();
+}
+
+void ThreadPool::runWorker()
+{
+    for (;;)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> l (lock);
+            jobAdded.wait (l, [this] { return shouldExit || ! jobs.empty(); });
+
+            if (shouldExit)
+                return;
+
+            job = std::move (jobs.front());
+            jobs.pop_front();
+        }
+
+        try
+        {
+            job();
+        }
+        catch (...) {}
+    }
+}
+
+void ThreadPool::parallelFor (size_t numItems, const std::function<void(size_t)>& function)
+{
+    struct SharedState
+    {
+        SharedState (const std::function<void(size_t)>& f, size_t num) : function (f), numItems (num) {}
+
+        // Helpers which start after all the items have been claimed never touch the
+        // function, so it's safe for it to go out of scope once the caller returns
+        void runItems()
+        {
+            for (;;)
+            {
+                auto item = nextItem++;
+
+                if (item >= numItems)
+                    return;
+
+                try
+                {
+                    function (item);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> l (lock);
+
+                    if (error == nullptr)
+                        error = std::current_exception();
+                }
+
+                if (++numDone == numItems)
+                {
+                    std::lock_guard<std::mutex> l (lock);
+                    finished.notify_all();
+                }
+            }
+        }
+
+        const std::function<void(size_t)>& function;
+        const size_t numItems;
+        std::atomic<size_t> nextItem { 0 }, numDone { 0 };
+        std::mutex lock;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+
+    if (numItems == 0)
+        return;
+
+    auto state = std::make_shared<SharedState> (function, numItems);
+    auto numHelpers = std::min (numItems - 1, threads.size());
+
+    for (size_t i = 0; i < numHelpers; ++i)
+        addJob ([state] { state->runItems(); });
+
+    state->runItems();
+
+    {
+        std::unique_lock<std::mutex> l (state->lock);
+        state->finished.wait (l, [&] { return state->numDone == numItems; });
+    }
+
+    if (state->error != nullptr)
+        std::rethrow_exception (state->error);
+}
+
+} // namespace soul
@@ -0,0 +1,72 @@
+/*
+    _____ _____ _____ __
+   |   __|     |  |  |  |      The SOUL language
+   |__   |  |  |  |  |  |__    Copyright (c) 2019 - ROLI Ltd.
+   |_____|_____|_____|_____|
+
+   The code in this file is provided under the terms of the ISC license:
+
+   Permission to use, copy, modify, and/or distribute this software for any purpose
+   with or without fee is hereby granted, provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+   TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+   NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+   DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+   IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+   CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+namespace soul
+{
+
+//==============================================================================
+/**
+    A fixed-size set of worker threads which run jobs from a shared queue.
+*/
+class ThreadPool
+{
+public:
+    /** Creates a pool with the given number of threads, or one thread per hardware
+        thread if the number is 0.
+    */
+    ThreadPool (uint32_t numThreads = 0);
+
+    /** Stops the threads, waiting for any running jobs to finish. Jobs which haven't
+        yet started will be discarded.
+    */
+    ~ThreadPool();
+
+    ThreadPool (const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    uint32_t getNumThreads() const      { return (uint32_t) threads.size(); }
+
+    using Job = std::function<void()>;
+
+    /** Adds a job to the end of the queue.
+        Any exception that the job throws will be caught and ignored.
+    */
+    void addJob (Job);
+
+    /** Calls the function for every index from 0 to numItems - 1, spreading the calls
+        across the pool's threads, and returning when they've all been completed.
+
+        The calling thread also takes part, so this is safe to use from inside a job that
+        is itself running on the same pool. If any of the calls throws an exception, the
+        first one will be re-thrown on the calling thread once all the calls have finished.
+    */
+    void parallelFor (size_t numItems, const std::function<void(size_t)>& function);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable jobAdded;
+    std::deque<Job> jobs;
+    bool shouldExit = false;
+
+    void runWorker();
+};
+
+} // namespace soul
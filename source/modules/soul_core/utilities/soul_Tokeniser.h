@@ -141,25 +141,57 @@ private:
     UTF8Reader input;
     TokenType literalType = {};
 
+    //==============================================================================
+    /** Identifier characters are always ASCII, so identifiers can be scanned a byte at a
+        time using a lookup table, without decoding any UTF-8.
+    */
+    struct IdentifierCharTable
+    {
+        bool isStart[256] = {}, isBody[256] = {};
+    };
+
+    static constexpr IdentifierCharTable createIdentifierCharTable()
+    {
+        IdentifierCharTable table;
+
+        for (UnicodeChar c = 1; c < 128; ++c)
+        {
+            table.isStart[c] = IdentifierMatcher::isIdentifierStart (c);
+            table.isBody[c]  = IdentifierMatcher::isIdentifierBody (c);
+        }
+
+        return table;
+    }
+
+    static constexpr IdentifierCharTable identifierChars = createIdentifierCharTable();
+
+    static bool isIdentifierStartByte (char c) noexcept    { return identifierChars.isStart[static_cast<uint8_t> (c)]; }
+    static bool isIdentifierBodyByte (char c) noexcept     { return identifierChars.isBody[static_cast<uint8_t> (c)]; }
+
     TokenType matchNextToken()
     {
-        if (IdentifierMatcher::isIdentifierStart (*input))
+        auto start = input.getAddress();
+
+        if (isIdentifierStartByte (*start))
         {
-            auto end = input;
-            int len = 1;
+            auto end = start + 1;
+
+            while (isIdentifierBodyByte (*end))
+                ++end;
+
+            auto len = static_cast<int> (end - start);
 
-            while (IdentifierMatcher::isIdentifierBody (*++end))
-                if (++len > (int) maxIdentifierLength)
-                    throwError (Errors::identifierTooLong());
+            if (len > (int) maxIdentifierLength)
+                throwError (Errors::identifierTooLong());
 
             if (auto keyword = KeywordList::match (len, input))
             {
-                input += len;
+                input = UTF8Reader (end);
                 return keyword;
             }
 
-            currentStringValue = std::string (input.getAddress(), end.getAddress());
-            input = end;
+            currentStringValue = std::string (start, end);
+            input = UTF8Reader (end);
             return Token::identifier;
         }
 
@@ -199,29 +231,57 @@ private:
         return Token::eof;
     }
 
+    /** Whitespace and the characters that end comments are all ASCII, and UTF-8 never uses
+        ASCII values inside a multi-byte sequence, so this scans raw bytes rather than decoding
+        characters. Comment bodies are skipped with strchr, which the C library vectorises.
+    */
     void skipWhitespaceAndComments()
     {
+        auto p = input.getAddress();
+
         for (;;)
         {
-            input = input.findEndOfWhitespace();
+            while (isWhitespace (*p))
+                ++p;
 
-            if (*input == '/')
+            if (p[0] == '/')
             {
-                auto c2 = *(input + 1);
-
-                if (c2 == '/')  { input = input.find ("\n"); continue; }
+                if (p[1] == '/')
+                {
+                    auto lineEnd = std::strchr (p + 2, '\n');
+                    p = lineEnd != nullptr ? lineEnd : p + std::strlen (p);
+                    continue;
+                }
 
-                if (c2 == '*')
+                if (p[1] == '*')
                 {
-                    location.location = input;
-                    input = (input + 2).find ("*/");
-                    if (input.isEmpty()) throwError (Errors::unterminatedComment());
-                    input += 2; continue;
+                    auto commentEnd = p + 2;
+
+                    for (;;)
+                    {
+                        commentEnd = std::strchr (commentEnd, '*');
+
+                        if (commentEnd == nullptr)
+                        {
+                            location.location = UTF8Reader (p);
+                            throwError (Errors::unterminatedComment());
+                        }
+
+                        if (commentEnd[1] == '/')
+                            break;
+
+                        ++commentEnd;
+                    }
+
+                    p = commentEnd + 2;
+                    continue;
                 }
             }
 
             break;
         }
+
+        input = UTF8Reader (p);
     }
 
     TokenType parseNumericLiteral (bool isNegative)
@@ -70,6 +70,8 @@ struct ThreadedVenue  : public soul::Venue
             {
                 unload();
 
+                SOUL_PROFILE_PHASE ("performer load");
+
                 if (performer->load (messageList, p))
                 {
                     setState (State::loaded);
@@ -123,6 +125,8 @@ struct ThreadedVenue  : public soul::Venue
 
         bool link (CompileMessageList& messageList, const LinkOptions& linkOptions) override
         {
+            SOUL_PROFILE_PHASE ("performer link");
+
             if (state == State::loaded && performer->link (messageList, linkOptions, {}))
             {
                 setState (State::linked);
@@ -141,6 +145,10 @@ struct ThreadedVenue  : public soul::Venue
             return s;
         }
 
+        void setRenderProfilingEnabled (bool b) override               { renderProfiler.setEnabled (b); }
+        RenderProfiler::Statistics getRenderStatistics() override      { return renderProfiler.getStatistics(); }
+        void resetRenderStatistics() override                          { renderProfiler.reset(); }
+
         void setStateChangeCallback (StateChangeCallbackFn f) override
         {
             stateChangeCallback = std::move (f);
@@ -151,6 +159,7 @@ struct ThreadedVenue  : public soul::Venue
         std::unique_ptr<Performer> performer;
         std::thread renderThread;
         CPULoadMeasurer loadMeasurer;
+        RenderProfiler renderProfiler;
         StateChangeCallbackFn stateChangeCallback;
         std::atomic<State> state { State::empty };
 
@@ -183,7 +192,12 @@ struct ThreadedVenue  : public soul::Venue
             while (! shouldStop.load())
             {
                 loadMeasurer.startMeasurement();
-                performer->advance (512);
+
+                {
+                    RenderProfiler::ScopedBlock profileBlock (renderProfiler, 512);
+                    performer->advance (512);
+                }
+
                 loadMeasurer.stopMeasurement();
             }
 
@@ -111,6 +111,23 @@ public:
         /** Returns the venue's current status. */
         virtual Status getStatus() = 0;
 
+        /** Turns on collection of per-block render timings for this session.
+            Profiling is off by default, and enabling it adds only a couple of clock
+            reads per block to the render thread. Venues which don't support profiling
+            can leave this unimplemented, in which case it does nothing.
+            @see getRenderStatistics
+        */
+        virtual void setRenderProfilingEnabled (bool /*shouldBeEnabled*/) {}
+
+        /** Returns a snapshot of the render timings that have been collected since profiling
+            was enabled or last reset. This can be called from any thread without blocking
+            the renderer. By default this returns an empty set of statistics.
+        */
+        virtual RenderProfiler::Statistics getRenderStatistics()        { return {}; }
+
+        /** Clears the render timings that have been collected so far. */
+        virtual void resetRenderStatistics()                            {}
+
         /** A callback function to indicate that the venue's state has changed.
             @see setStateChangeCallback
         */
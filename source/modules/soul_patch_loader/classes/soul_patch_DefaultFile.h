@@ -88,9 +88,9 @@ struct RemoteFile  : public RefCountHelper<VirtualFile>
 /** A local-file-based implementation of VirtualFile */
 struct LocalFile  : public RefCountHelper<VirtualFile>
 {
-    LocalFile (juce::File f) : file (std::move (f)) {}
+    LocalFile (juce::File f) : file (std::move (f))   { getLiveObjects().add (this); }
     LocalFile (const juce::String& path) : LocalFile (juce::File::getCurrentWorkingDirectory().getChildFile (path)) {}
-    ~LocalFile() override = default;
+    ~LocalFile() override                              { getLiveObjects().remove (this); }
 
     String::Ptr getName() override                 { return makeString (file.getFileName()); }
     String::Ptr getAbsolutePath() override         { return makeString (file.getFullPathName()); }
@@ -143,8 +143,46 @@ struct LocalFile  : public RefCountHelper<VirtualFile>
     }
 
     juce::File file;
+
+    /** Returns the LocalFile at this address, or nullptr if the object isn't one. This avoids
+        a dynamic_cast, which isn't safe for VirtualFile objects that were created by a host.
+    */
+    static LocalFile* findLiveObject (VirtualFile& f)
+    {
+        auto& liveObjects = getLiveObjects();
+        std::lock_guard<std::mutex> l (liveObjects.lock);
+
+        if (liveObjects.objects.find (&f) != liveObjects.objects.end())
+            return static_cast<LocalFile*> (&f);
+
+        return {};
+    }
+
+private:
+    struct LiveObjects
+    {
+        void add (VirtualFile* f)       { std::lock_guard<std::mutex> l (lock); objects.insert (f); }
+        void remove (VirtualFile* f)    { std::lock_guard<std::mutex> l (lock); objects.erase (f); }
+
+        std::mutex lock;
+        std::unordered_set<VirtualFile*> objects;
+    };
+
+    static LiveObjects& getLiveObjects()
+    {
+        static LiveObjects liveObjects;
+        return liveObjects;
+    }
 };
 
+static juce::File getLocalFileIfOwnedByLoader (VirtualFile& f)
+{
+    if (auto localFile = LocalFile::findLiveObject (f))
+        return localFile->file;
+
+    return {};
+}
+
 //==============================================================================
 /** Creates either a LocalFile or RemoteFile object, based on the path provided */
 inline static VirtualFile* createLocalOrRemoteFile (const juce::String& path)
@@ -117,6 +117,7 @@ struct PatchInstanceImpl  : public RefCountHelper<PatchInstance>
     }
 
     std::unique_ptr<soul::PerformerFactory> performerFactory;
+    std::shared_ptr<ThreadPool> loaderThreadPool { getLoaderThreadPool() }; // keeps the pool running between builds
     const VirtualFile::Ptr root;
     FileList fileList;
     Description description;
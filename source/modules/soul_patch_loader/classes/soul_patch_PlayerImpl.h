@@ -43,6 +43,7 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
     Span<CompilationMessage> getCompileMessages() const override    { return compileMessagesSpan; }
     bool isPlayable() const override                                { return ! anyErrors; }
     Description getDescription() const override                     { return fileList.createDescription(); }
+    uint32_t getLatencyInFrames() const override                    { return wrapper != nullptr ? wrapper->getLatencyInFrames() : 0; }
 
     bool needsRebuilding (const PatchPlayerConfiguration& newConfig) override
     {
@@ -124,18 +125,40 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         if (program.isEmpty())
             return messageList.addError ("Empty program", {});
 
-        if (! performer->load (messageList, program))
-            return messageList.addError ("Failed to load program", {});
+        {
+            SOUL_PROFILE_PHASE ("performer load");
+
+            if (! performer->load (messageList, program))
+                return messageList.addError ("Failed to load program", {});
+        }
 
         createBuses();
         createParameters (program.getStringDictionary());
         connectEndpoints();
+        wrapper->setSuspendWhenSilent (getNumSilentBlocksBeforeSuspending (program, linkOptions));
+
+        auto prefetchedFiles = prefetchExternalAudioFiles (program, externalDataProvider);
 
         auto options = linkOptions;
-        options.externalValueProvider = [this, externalDataProvider] (ConstantTable& constantTable,
-                                                                      const char* name, const Type& type,
-                                                                      const Annotation& annotation) -> ConstantTable::Handle
+        options.externalValueProvider = [this, externalDataProvider, &prefetchedFiles] (ConstantTable& constantTable,
+                                                                                        const char* name, const Type& type,
+                                                                                        const Annotation& annotation) -> ConstantTable::Handle
         {
+            auto prefetched = prefetchedFiles.find (name);
+
+            if (prefetched != prefetchedFiles.end())
+            {
+                auto data = std::move (prefetched->second);
+                prefetchedFiles.erase (prefetched);
+
+                // If this fails, we fall back to the normal path below, which will report the error properly
+                try
+                {
+                    return constantTable.getHandleForValue (AudioFileToValue::convert (std::move (data), type, constantTable));
+                }
+                catch (const PatchLoadError&) {}
+            }
+
             if (externalDataProvider != nullptr)
                 if (auto file = externalDataProvider->getExternalFile (name))
                     return constantTable.getHandleForValue (AudioFileToValue::load (std::move (file), type, annotation, constantTable));
@@ -143,6 +166,8 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
             return findExternalDefinitionInManifest (constantTable, name, type, annotation);
         };
 
+        SOUL_PROFILE_PHASE ("performer link");
+
         if (! performer->link (messageList, options, CacheConverter::create (cache).get()))
             return messageList.addError ("Failed to link", {});
     }
@@ -183,6 +208,99 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
             anyErrors = anyErrors || m.isError;
     }
 
+    using PrefetchedAudioFiles = std::unordered_map<std::string, AudioFileToValue::DecodedData>;
+
+    /** Finds the externals in the program which refer to audio files, and decodes them all
+        concurrently before linking, so the linker doesn't have to load them one at a time.
+        Any that fail to decode are skipped here, and will be retried (and their errors reported)
+        when the linker asks for them. Any other kind of failure is reported straight away.
+    */
+    PrefetchedAudioFiles prefetchExternalAudioFiles (const soul::Program& program, ExternalDataProvider* externalDataProvider) const
+    {
+        struct PendingFile
+        {
+            std::string name;
+            VirtualFile::Ptr file;
+            const Annotation* annotation;
+            AudioFileToValue::DecodedData data;
+            bool succeeded = false;
+            std::string error;
+        };
+
+        std::vector<PendingFile> pendingFiles;
+
+        for (auto& module : program.getModules())
+        {
+            for (auto& v : module->stateVariables)
+            {
+                if (v->isExternal())
+                {
+                    auto name = TokenisedPathString::join (module->getNameWithoutRootNamespace(), v->name.toString());
+
+                    if (auto file = findExternalAudioFile (name, externalDataProvider))
+                        pendingFiles.push_back ({ name, std::move (file), std::addressof (v->annotation), {} });
+                }
+            }
+        }
+
+        getLoaderThreadPool()->parallelFor (pendingFiles.size(), [&] (size_t i)
+        {
+            auto& f = pendingFiles[i];
+
+            try
+            {
+                f.data = AudioFileToValue::decode (f.file, *f.annotation);
+                f.succeeded = true;
+            }
+            catch (const PatchLoadError&) {}
+            catch (const std::exception& e)     { f.error = e.what(); }
+            catch (...)                         { f.error = "unknown error"; }
+        });
+
+        PrefetchedAudioFiles results;
+
+        for (auto& f : pendingFiles)
+        {
+            if (! f.error.empty())
+                throwPatchLoadError (f.file->getAbsolutePath().toString<juce::String>(),
+                                     "Failed to load external " + quoteName (f.name) + ": " + f.error);
+
+            if (f.succeeded)
+                results[f.name] = std::move (f.data);
+        }
+
+        return results;
+    }
+
+    VirtualFile::Ptr findExternalAudioFile (const std::string& name, ExternalDataProvider* externalDataProvider) const
+    {
+        if (externalDataProvider != nullptr)
+            if (auto file = externalDataProvider->getExternalFile (name.c_str()))
+                return file;
+
+        if (auto externals = fileList.getExternalsList())
+        {
+            for (auto& e : externals->getProperties())
+            {
+                if (e.name.toString().trim() == name.c_str())
+                {
+                    if (e.value.isString())
+                    {
+                        try
+                        {
+                            return fileList.checkAndCreateVirtualFile (e.value.toString());
+                        }
+                        catch (const PatchLoadError&) {}
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return {};
+    }
+
     ConstantTable::Handle findExternalDefinitionInManifest (ConstantTable& constantTable,
                                                             const char* name, const Type& type,
                                                             const Annotation& annotation) const
@@ -240,28 +358,66 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         auto inputEndpoints = performer->getInputEndpoints();
         parameters.reserve (inputEndpoints.size());
 
+        auto numParameters = (size_t) std::count_if (inputEndpoints.begin(), inputEndpoints.end(),
+                                                     [] (const InputEndpoint::Ptr& i) { return isParameterInput (*i); });
+
+        changedParameters = std::make_shared<ParameterChangeFlags> (numParameters);
+
+        // Ramp lengths are given in frames at the host's rate
+        auto rampLengthScale = config.sampleRate > 0 ? getInternalSampleRate() / config.sampleRate : 1.0;
+
         for (auto& i : inputEndpoints)
         {
             if (isParameterInput (*i))
-                parameters.push_back (Parameter::Ptr (new ParameterImpl (stringDictionary, *i, endpointProperties)));
+                parameters.push_back (Parameter::Ptr (new ParameterImpl (stringDictionary, *i, endpointProperties, rampLengthScale,
+                                                                         changedParameters, parameters.size())));
         }
 
+        changedParameters->markAllChanged();
         parameterSpan = makeSpan (parameters);
     }
 
     void connectEndpoints()
     {
         wrapper = std::make_unique<SynchronousPerformerWrapper> (*performer);
-        wrapper->attach (getEndpointProperties());
+        wrapper->attach (getEndpointProperties(), config.sampleRate);
+    }
+
+    /** A patch can be suspended while silent either by the host's link options, or by its
+        main processor having a "suspendWhenSilent" annotation, which can be a number of
+        blocks, or just true to use a default.
+    */
+    static uint32_t getNumSilentBlocksBeforeSuspending (const soul::Program& program, const soul::LinkOptions& linkOptions)
+    {
+        if (auto numBlocks = linkOptions.getSuspendWhenSilent())
+            return numBlocks;
+
+        if (auto mainProcessor = program.getMainProcessor())
+        {
+            auto& annotation = mainProcessor->annotation;
+
+            if (annotation.getValue ("suspendWhenSilent").getType().isPrimitiveInteger())
+                return (uint32_t) std::max ((int64_t) 0, annotation.getInt64 ("suspendWhenSilent"));
+
+            if (annotation.getBool ("suspendWhenSilent"))
+                return defaultNumSilentBlocksBeforeSuspending;
+        }
+
+        return 0;
     }
 
+    static constexpr uint32_t defaultNumSilentBlocksBeforeSuspending = 16;
+
     //==============================================================================
     void reset() override
     {
         performer->reset();
 
-        for (auto& p : parameters)
-            static_cast<ParameterImpl&>(*p).changed = true;
+        if (wrapper != nullptr)
+            wrapper->reset();
+
+        if (changedParameters != nullptr)
+            changedParameters->markAllChanged();
     }
 
     RenderResult render (const RenderContext& rc) override
@@ -288,15 +444,94 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         auto midi = rc.incomingMIDI;
         auto midiEnd = midi != nullptr ? midi + rc.numMIDIMessages : nullptr;
 
+        if (changedParameters->takeChanges())
+            wrapper->wakeUp();
+
         wrapper->render (input, output, midi, midiEnd);
 
         return RenderResult::ok;
     }
 
+    //==============================================================================
+    /** A lock-free set of dirty-bits, one per parameter.
+
+        Any thread may mark a parameter as changed. Once per block, the render thread calls
+        takeChanges(), which moves all the dirty bits into a pending set that only the render
+        thread uses, so when nothing has been touched, the whole set costs a single atomic read.
+
+        The performer still polls one source callback per parameter endpoint, but all that
+        each callback does is test and clear its bit in the pending set, which is a few
+        adjacent words shared by all the parameters.
+    */
+    struct ParameterChangeFlags
+    {
+        ParameterChangeFlags (size_t numParametersToTrack)
+            : numParameters (numParametersToTrack),
+              flags ((numParametersToTrack + bitsPerWord - 1) / bitsPerWord),
+              pending (flags.size())
+        {
+            for (auto& f : flags)
+                f.store (0, std::memory_order_relaxed);
+        }
+
+        void markChanged (size_t parameterIndex) noexcept
+        {
+            SOUL_ASSERT (parameterIndex < numParameters);
+            flags[parameterIndex / bitsPerWord].fetch_or (Word (1) << (parameterIndex % bitsPerWord), std::memory_order_release);
+            anyChanged.store (true, std::memory_order_release);
+        }
+
+        void markAllChanged() noexcept
+        {
+            for (size_t i = 0; i < numParameters; ++i)
+                markChanged (i);
+        }
+
+        /** Called by the render thread once per block. This clears all the flags, adding
+            them to the pending set, and returns true if any of them had been set.
+        */
+        bool takeChanges() noexcept
+        {
+            if (! anyChanged.exchange (false, std::memory_order_acquire))
+                return false;
+
+            for (size_t i = 0; i < flags.size(); ++i)
+                pending[i] |= flags[i].exchange (0, std::memory_order_acquire);
+
+            return true;
+        }
+
+        /** Called by the render thread: returns true if the given parameter is in the
+            pending set, and removes it.
+        */
+        bool takePendingChange (size_t parameterIndex) noexcept
+        {
+            auto& word = pending[parameterIndex / bitsPerWord];
+            auto mask = Word (1) << (parameterIndex % bitsPerWord);
+
+            if ((word & mask) == 0)
+                return false;
+
+            word &= ~mask;
+            return true;
+        }
+
+    private:
+        using Word = uint64_t;
+        static constexpr size_t bitsPerWord = sizeof (Word) * 8;
+
+        const size_t numParameters;
+        std::vector<std::atomic<Word>> flags;
+        std::vector<Word> pending;
+        std::atomic<bool> anyChanged { false };
+    };
+
     //==============================================================================
     struct ParameterImpl  : public RefCountHelper<Parameter>
     {
-        ParameterImpl (const StringDictionary& stringDictionary, InputEndpoint& input, EndpointProperties endpointProperties)
+        ParameterImpl (const StringDictionary& stringDictionary, InputEndpoint& input, EndpointProperties endpointProperties,
+                       double rampLengthScale, std::shared_ptr<ParameterChangeFlags> flags, size_t indexInFlags)
+            : changeFlags (std::move (flags)), changeFlagIndex (indexInFlags)
         {
             const auto& details = input.getDetails();
 
@@ -330,7 +565,7 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
             maxValue     = castValueToFloat (details.annotation.getValue ("max"), maxValue);
             step         = castValueToFloat (details.annotation.getValue ("step"), maxValue / (numIntervals == 0 ? 1000 : numIntervals));
             initialValue = castValueToFloat (details.annotation.getValue ("init"), minValue);
-            rampFrames   = checkRampLength (details.annotation.getValue ("rampFrames"));
+            rampFrames   = checkRampLength (details.annotation.getValue ("rampFrames"), rampLengthScale);
 
             value = initialValue;
 
@@ -338,10 +573,9 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
             {
                 input.setEventSource ([this] (size_t, uint32_t, callbacks::PostNextEvent postEvent)
                 {
-                    if (changed)
+                    if (changeFlags->takePendingChange (changeFlagIndex))
                     {
-                        changed = false;
-                        auto v = value;
+                        float v = value;
                         postEvent (std::addressof (v));
                     }
 
@@ -354,10 +588,9 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
                 input.setSparseStreamSource ([this] (uint64_t /*totalFramesElapsed*/,
                                                      callbacks::SetSparseStreamTarget setTargetValue) -> uint32_t
                 {
-                    if (changed)
+                    if (changeFlags->takePendingChange (changeFlagIndex))
                     {
-                        changed = false;
-                        auto v = value;
+                        float v = value;
                         setTargetValue (&v, rampFrames, 0.0f);
                     }
 
@@ -384,11 +617,8 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         {
             newValue = snapToLegalValue (newValue);
 
-            if (value != newValue)
-            {
-                value = newValue;
-                changed = true;
-            }
+            if (value.exchange (newValue) != newValue)
+                changeFlags->markChanged (changeFlagIndex);
         }
 
         String::Ptr getProperty (const char* propertyName) const override
@@ -412,8 +642,9 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         }
 
         uint32_t rampFrames;
-        float value = 0;
-        std::atomic<bool> changed { true };
+        std::atomic<float> value { 0 };
+        std::shared_ptr<ParameterChangeFlags> changeFlags;
+        const size_t changeFlagIndex;
         Annotation annotation;
         std::vector<std::string> propertyNameStrings;
         std::vector<const char*> propertyNameRawStrings;
@@ -429,27 +660,42 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
         return defaultValue;
     }
 
-    static uint32_t checkRampLength (const soul::Value& v)
+    static uint32_t checkRampLength (const soul::Value& v, double scale)
     {
+        auto frames = (int64_t) 1000;
+
         if (v.getType().isPrimitive() && (v.getType().isFloatingPoint() || v.getType().isInteger()))
-        {
-            auto frames = v.getAsInt64();
+            frames = v.getAsInt64();
 
-            if (frames < 0)
-                return 0;
+        frames = (int64_t) std::llround ((double) frames * scale);
 
-            if (frames > maxRampLength)
-                return (uint32_t) maxRampLength;
+        if (frames < 0)
+            return 0;
 
-            return (uint32_t) frames;
-        }
+        if (frames > maxRampLength)
+            return (uint32_t) maxRampLength;
 
-        return 1000;
+        return (uint32_t) frames;
+    }
+
+    /** Returns the rate at which the performer itself runs, which may differ from the host's. */
+    double getInternalSampleRate() const
+    {
+        if (config.internalSampleRate > 0)
+            return config.internalSampleRate;
+
+        if (config.oversamplingFactor > 1)
+            return config.sampleRate * config.oversamplingFactor;
+
+        return config.sampleRate;
     }
 
     EndpointProperties getEndpointProperties() const
     {
-        return { config.sampleRate, (uint32_t) config.maxFramesPerBlock };
+        auto internalRate = getInternalSampleRate();
+
+        return { internalRate, SynchronousPerformerWrapper::getMaxPerformerBlockSize ((uint32_t) config.maxFramesPerBlock,
+                                                                                       config.sampleRate, internalRate) };
     }
 
     std::vector<CompilationMessage> compileMessages;
@@ -460,6 +706,7 @@ struct PatchPlayerImpl  : public RefCountHelper<PatchPlayer>
 
     std::vector<Bus> inputBuses, outputBuses;
     std::vector<Parameter::Ptr> parameters;
+    std::shared_ptr<ParameterChangeFlags> changedParameters;
 
     Span<Bus> inputBusesSpan = {}, outputBusesSpan = {};
     Span<Parameter::Ptr> parameterSpan = {};
@@ -22,7 +22,14 @@ namespace soul::patch
 {
 
 //==============================================================================
-bool operator== (PatchPlayerConfiguration s1, PatchPlayerConfiguration s2)    { return s1.sampleRate == s2.sampleRate && s1.maxFramesPerBlock == s2.maxFramesPerBlock; }
+bool operator== (PatchPlayerConfiguration s1, PatchPlayerConfiguration s2)
+{
+    return s1.sampleRate == s2.sampleRate
+        && s1.maxFramesPerBlock == s2.maxFramesPerBlock
+        && s1.oversamplingFactor == s2.oversamplingFactor
+        && s1.internalSampleRate == s2.internalSampleRate;
+}
+
 bool operator!= (PatchPlayerConfiguration s1, PatchPlayerConfiguration s2)    { return ! (s1 == s2); }
 
 static bool isValidPathString (const char* s)
@@ -53,6 +60,30 @@ struct PatchLoadError
     throwPatchLoadError ((file + ": error: " + message).toStdString());
 }
 
+//==============================================================================
+/** Returns the set of worker threads that the loader uses for heavy tasks like decoding
+    and resampling external audio data.
+    The pool is shared by everything holding a pointer to it, and its threads are stopped
+    when the last one is released, rather than by a static destructor, which might run
+    while the library is being unloaded, when it's not safe to wait for threads.
+*/
+static std::shared_ptr<ThreadPool> getLoaderThreadPool()
+{
+    static std::mutex lock;
+    static std::weak_ptr<ThreadPool> sharedPool;
+
+    std::lock_guard<std::mutex> l (lock);
+    auto pool = sharedPool.lock();
+
+    if (pool == nullptr)
+    {
+        pool = std::make_shared<ThreadPool>();
+        sharedPool = pool;
+    }
+
+    return pool;
+}
+
 //==============================================================================
 inline uint32_t getFrameIndex (MIDIMessage m)        { return (uint32_t) m.frameIndex; }
 inline uint32_t getPackedMIDIEvent (MIDIMessage m)   { return (((uint32_t) m.byte0) << 16) | (((uint32_t) m.byte1) << 8) | (uint32_t) m.byte2; }
@@ -148,6 +179,12 @@ private:
     }
 };
 
+//==============================================================================
+/** If this VirtualFile is a LocalFile that was created by this library, this returns the
+    file that it refers to, or otherwise an empty File. (Defined in soul_patch_DefaultFile.h)
+*/
+static juce::File getLocalFileIfOwnedByLoader (VirtualFile&);
+
 //==============================================================================
 /** Attempts to read some sort of audio file and convert it into a suitable Value
     contains the content.
@@ -157,32 +194,66 @@ private:
 */
 struct AudioFileToValue
 {
+    /** The raw contents of an audio file, before it has been converted to a particular type. */
+    struct DecodedData
+    {
+        Value frames;   // a float<numChannels>[numFrames] array, or invalid if the file was empty
+        double sampleRate = 0;
+    };
+
     static Value load (VirtualFile::Ptr file, const Type& type,
                        const Annotation& annotation, ConstantTable& constantTable)
+    {
+        return convert (decode (std::move (file), annotation), type, constantTable);
+    }
+
+    /** Reads and decodes a file, applying any resampling or channel extraction requested
+        by the annotation. This doesn't touch a ConstantTable, so can be run on any thread.
+    */
+    static DecodedData decode (VirtualFile::Ptr file, const Annotation& annotation)
     {
         SOUL_ASSERT (file != nullptr);
         std::string fileName (file->getAbsolutePath()->getCharPointer());
 
+        if (auto reader = createMemoryMappedReader (*file))
+            return decode (*reader, fileName, annotation);
+
         if (auto reader = createAudioFileReader (file))
-            return loadAudioFileAsValue (*reader, fileName, type, annotation, constantTable);
+            return decode (*reader, fileName, annotation);
 
         throwPatchLoadError ("Failed to read file " + quoteName (fileName));
         return {};
     }
 
+    /** Converts some decoded data into a value of the given type. */
+    static Value convert (DecodedData data, const Type& type, ConstantTable& constantTable)
+    {
+        if (! data.frames.isValid())
+            return {};
+
+        auto result = convertAudioDataToType (type, constantTable, std::move (data.frames), data.sampleRate);
+
+        if (! result.isValid())
+            throwPatchLoadError ("Could not convert audio file to type " + quoteName (type.getDescription()));
+
+        return result;
+    }
+
 private:
-    static constexpr unsigned int maxNumChannels = 8;
-    static constexpr uint64_t maxNumFrames = 48000 * 60;
+    static constexpr unsigned int maxNumChannels = (unsigned int) Type::maxVectorSize;
+    static constexpr uint64_t maxNumFrames = 48000 * 60 * 60;
+    static constexpr uint64_t maxDecodedDataSize = 512 * 1024 * 1024;
+    static constexpr uint32_t framesPerReadChunk = 65536;
 
-    static Value loadAudioFileAsValue (juce::AudioFormatReader& reader, const std::string& fileName,
-                                       const Type& type, const Annotation& annotation, ConstantTable& constantTable)
+    static DecodedData decode (juce::AudioFormatReader& reader, const std::string& fileName, const Annotation& annotation)
     {
         if (reader.sampleRate > 0)
         {
             if (reader.numChannels > maxNumChannels)
                 throwPatchLoadError ("Too many channels in audio file: " + quoteName (fileName));
 
-            if (reader.lengthInSamples > (juce::int64) maxNumFrames)
+            if (reader.lengthInSamples > (juce::int64) maxNumFrames
+                 || ! isSmallEnoughToLoad (reader.numChannels, (uint64_t) reader.lengthInSamples))
                 throwPatchLoadError ("Audio file was too long to load into memory: " + quoteName (fileName));
 
             auto numSourceChannels = (uint32_t) reader.numChannels;
@@ -191,16 +262,31 @@ private:
             if (numFrames == 0)
                 return {};
 
-            AllocatedChannelSet<DiscreteChannelSet<float>> buffer (numSourceChannels, numFrames);
-            reader.read (buffer.channelSet.channels, (int) numSourceChannels, 0, (int) numFrames);
+            auto resampleRate    = annotation.getValue ("resample");
+            auto sourceChannel   = annotation.getValue ("sourceChannel");
+            DecodedData result;
+            result.sampleRate = reader.sampleRate;
 
-            resampleAudioDataIfNeeded (buffer, reader.sampleRate, annotation.getValue ("resample"));
-            extractChannelIfNeeded (buffer, annotation.getValue ("sourceChannel"));
+            if (resampleRate.isValid() || sourceChannel.isValid())
+            {
+                AllocatedChannelSet<DiscreteChannelSet<float>> buffer (numSourceChannels, numFrames);
+                reader.read (buffer.channelSet.channels, (int) numSourceChannels, 0, (int) numFrames);
 
-            auto result = convertAudioDataToType (type, constantTable, buffer.channelSet, reader.sampleRate);
+                resampleAudioDataIfNeeded (buffer, reader.sampleRate, resampleRate);
+                extractChannelIfNeeded (buffer, sourceChannel);
 
-            if (! result.isValid())
-                throwPatchLoadError ("Could not convert audio file to type " + quoteName (type.getDescription()));
+                result.frames = Value::createInterleavedFloatArray (buffer.channelSet.numChannels, buffer.channelSet);
+            }
+            else
+            {
+                // When the data doesn't need any processing, it can be decoded a chunk at a time
+                // straight into the final array, so we never hold a second full-length copy of it
+                result.frames = Value::zeroInitialiser (Type::createVector (PrimitiveType::float32, numSourceChannels)
+                                                          .createArray (numFrames));
+
+                readInChunks (reader, { static_cast<float*> (result.frames.getPackedData()),
+                                        numSourceChannels, numFrames, numSourceChannels });
+            }
 
             return result;
         }
@@ -208,6 +294,28 @@ private:
         return {};
     }
 
+    /** The decoded data stays resident, so this limits the total size, as well as the number
+        of channels and frames.
+    */
+    static bool isSmallEnoughToLoad (uint64_t numChannels, uint64_t numFrames)
+    {
+        return numChannels * numFrames * sizeof (float) <= maxDecodedDataSize;
+    }
+
+    static void readInChunks (juce::AudioFormatReader& reader, InterleavedChannelSet<float> dest)
+    {
+        auto numSourceChannels = (uint32_t) reader.numChannels;
+        AllocatedChannelSet<DiscreteChannelSet<float>> chunk (numSourceChannels, std::min (framesPerReadChunk, dest.numFrames));
+
+        for (uint32_t start = 0; start < dest.numFrames;)
+        {
+            auto numToDo = std::min (chunk.channelSet.numFrames, dest.numFrames - start);
+            reader.read (chunk.channelSet.channels, (int) numSourceChannels, (juce::int64) start, (int) numToDo);
+            copyChannelSetToFit (dest.getSlice (start, numToDo), chunk.channelSet.getSlice (0, numToDo));
+            start += numToDo;
+        }
+    }
+
     static void resampleAudioDataIfNeeded (AllocatedChannelSet<DiscreteChannelSet<float>>& buffer,
                                            double currentRate, const Value& resampleRate)
     {
@@ -230,10 +338,14 @@ private:
                 if (newNumFrames == buffer.channelSet.numFrames)
                     return;
 
-                if (newNumFrames > 0 && newNumFrames < maxNumFrames)
+                if (newNumFrames > 0 && newNumFrames < maxNumFrames
+                     && isSmallEnoughToLoad (buffer.channelSet.numChannels, newNumFrames))
                 {
-                    AllocatedChannelSet<DiscreteChannelSet<float>> newBuffer (buffer.channelSet.numChannels, (uint32_t) newNumFrames);
-                    resampleToFit (newBuffer.channelSet, buffer.channelSet);
+                    auto& source = buffer.channelSet;
+                    AllocatedChannelSet<DiscreteChannelSet<float>> newBuffer (source.numChannels, (uint32_t) newNumFrames);
+
+                    fastResampleToFit (newBuffer.channelSet, { source.channels, source.numChannels, source.offset, source.numFrames },
+                                       getLoaderThreadPool().get());
                     std::swap (newBuffer.channelSet, buffer.channelSet);
                     return;
                 }
@@ -265,6 +377,35 @@ private:
         }
     }
 
+    /** If this is one of the loader's own LocalFile objects, and refers to a WAV or AIFF file,
+        this maps it into memory rather than streaming it, which lets the OS page it in lazily
+        and skips a lot of copying. Files from anywhere else are always read through their
+        VirtualFile interface, even if their path matches a local file.
+    */
+    static std::unique_ptr<juce::AudioFormatReader> createMemoryMappedReader (VirtualFile& virtualFile)
+    {
+        auto file = getLocalFileIfOwnedByLoader (virtualFile);
+
+        if (! file.existsAsFile())
+            return {};
+
+        juce::WavAudioFormat wav;
+        juce::AiffAudioFormat aiff;
+
+        for (juce::AudioFormat* format : { static_cast<juce::AudioFormat*> (&wav), static_cast<juce::AudioFormat*> (&aiff) })
+        {
+            if (format->canHandleFile (file))
+            {
+                std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader (format->createMemoryMappedReader (file));
+
+                if (reader != nullptr && reader->mapEntireFile())
+                    return reader;
+            }
+        }
+
+        return {};
+    }
+
     static std::unique_ptr<juce::AudioFormatReader> createAudioFileReader (VirtualFile::Ptr file)
     {
         SOUL_ASSERT (file != nullptr);
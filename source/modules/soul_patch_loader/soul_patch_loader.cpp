@@ -20,6 +20,7 @@
 
 #include "../../API/soul_patch/API/soul_patch.h"
 #include "JuceHeader.h"
+#include <unordered_set>
 
 #include "../../API/soul_patch/helper_classes/soul_patch_Utilities.h"
 
@@ -110,6 +110,8 @@ public:
         {
             unload();
 
+            SOUL_PROFILE_PHASE ("performer load");
+
             if (performer->load (messageList, p))
             {
                 setState (State::loaded);
@@ -121,6 +123,8 @@ public:
 
         bool link (CompileMessageList& messageList, const LinkOptions& linkOptions) override
         {
+            SOUL_PROFILE_PHASE ("performer link");
+
             if (state == State::loaded && performer->link (messageList, linkOptions, {}))
             {
                 setState (State::linked);
@@ -202,6 +206,10 @@ public:
             stateChangeCallback = std::move (f);
         }
 
+        void setRenderProfilingEnabled (bool b) override               { renderProfiler.setEnabled (b); }
+        RenderProfiler::Statistics getRenderStatistics() override      { return renderProfiler.getStatistics(); }
+        void resetRenderStatistics() override                          { renderProfiler.reset(); }
+
         void prepareToPlay (juce::AudioIODevice& device)
         {
             updateEndpointProperties (device);
@@ -217,14 +225,18 @@ public:
                            const juce::MidiBuffer& midiEvents,
                            uint32_t numSamples)
         {
+            RenderProfiler::ScopedBlock profileBlock (renderProfiler, numSamples);
+
             if (midiEventQueue != nullptr && ! midiEvents.isEmpty())
             {
                 juce::MidiBuffer::Iterator iterator (midiEvents);
-                juce::MidiMessage message;
-                int samplePosition;
+                const juce::uint8* data;
+                int numBytes, samplePosition;
 
-                while (iterator.getNextEvent (message, samplePosition))
-                    midiEventQueue->enqueueEvent ((uint32_t) samplePosition, packMIDIMessageIntoInt (message));
+                // Reads the raw bytes in place, rather than copying each event into a MidiMessage
+                while (iterator.getNextEvent (data, numBytes, samplePosition))
+                    if (numBytes > 0 && numBytes < 4)
+                        midiEventQueue->enqueueEvent ((uint32_t) samplePosition, packMIDIMessageIntoInt (data, numBytes));
             }
 
             if (auto s = audioDeviceInputStream.get())
@@ -301,12 +313,10 @@ public:
                                                             (uint32_t) device.getCurrentBufferSizeSamples());
         }
 
-        static int packMIDIMessageIntoInt (const juce::MidiMessage& message)
+        static int packMIDIMessageIntoInt (const juce::uint8* rawData, int length)
         {
             uint32_t m = 0;
-            auto length = message.getRawDataSize();
-            SOUL_ASSERT (length < 4);
-            auto* rawData = message.getRawData();
+            SOUL_ASSERT (length > 0 && length < 4);
 
             m = ((uint32_t) rawData[0]) << 16;
 
@@ -499,6 +509,7 @@ public:
         std::unique_ptr<AudioDeviceOutputStream> audioDeviceOutputStream;
         std::unique_ptr<MidiEventQueueType> midiEventQueue;
         StateChangeCallbackFn stateChangeCallback;
+        RenderProfiler renderProfiler;
 
         State state = State::empty;
     };